@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Scheduler.h"
+
+/* Test stand application
+*
+* Acquisition, logging, the operation state machine and analysis. Everything it
+* needs from the board goes through Hal.h, so the same code runs on the Teensy
+* (src/main.cpp) and against the simulated backends (src/native/main.cpp).
+*/
+
+enum E_OPERATION_STATE : uint8_t {
+  STARTUP = 0,
+  ERROR =  1,
+  READY_FOR_COUNTDOWN = 2,
+  COUNTDOWN = 3,
+  TEST_ACTIVE = 4,
+  POST_TEST = 5,
+  OPERATION_STATE_COUNT
+};
+
+void AppSetup(void);
+
+// Runs at most one due task, false when nothing was due
+bool AppLoop(void);
+
+// ClockMicros() of the next task release
+uint64_t AppNextWakeup(void);
+
+E_OPERATION_STATE AppGetState(void);
+
+// Times a state was entered and us spent in it, including the current visit
+uint32_t AppGetStateEntries(E_OPERATION_STATE State);
+uint64_t AppGetStateTime(E_OPERATION_STATE State);
+
+// us from the start button interrupt to COUNTDOWN, 0 before the first press
+uint32_t AppGetStartLatency(void);
+const Scheduler& AppGetTasks(void);
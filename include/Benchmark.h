@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* Host micro-benchmark harness
+*
+* Each benchmark runs Iterations operations per call. The harness grows the
+* iteration count until a batch takes BENCHMARK_MIN_TIME, repeats it and keeps the
+* fastest batch. Heap allocations are counted through HalSimAllocations().
+*/
+
+#define BENCHMARK_MIN_TIME              0.05    // s per timed batch
+#define BENCHMARK_REPEATS               5
+
+typedef void (*BenchmarkFunction)(uint32_t Iterations);
+
+struct Benchmark
+{
+  const char* Name;
+  BenchmarkFunction Function;
+};
+
+struct BenchmarkResult
+{
+  const char* Name;
+  uint64_t Iterations;        // Per batch
+  double NsPerOp;             // Fastest batch
+  double AllocationsPerOp;
+};
+
+BenchmarkResult BenchmarkRun(const Benchmark& Entry, double MinTime = BENCHMARK_MIN_TIME);
+
+// Results as a JSON document
+void BenchmarkWriteJson(FILE* Out, const BenchmarkResult* Results, uint32_t Count);
+
+// Keeps the compiler from discarding a computed value
+template <typename T>
+inline void BenchmarkKeep(const T& Value)
+{
+  __asm__ volatile("" : : "r" (&Value) : "memory");
+}
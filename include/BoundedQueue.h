@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Bounded consumer queue with an overflow policy
+*
+* One per consumer of the sample pipeline, so a slow consumer only ever loses its
+* own samples. What happens when the consumer falls behind is chosen per queue,
+* and every lost item is counted. Single context only, no locking.
+*/
+
+#define QUEUE_DECIMATE_FACTOR           2   // Past half full, QUEUE_DECIMATE keeps one in this many
+
+enum E_QUEUE_POLICY : uint8_t {
+  QUEUE_DROP_NEWEST = 0,      // Full queue rejects new items, the consumer sees a gap after the backlog
+  QUEUE_DROP_OLDEST,          // Full queue overwrites its oldest item, the consumer always gets the latest
+  QUEUE_DECIMATE              // Lower rate instead of a gap, drops the newest once completely full
+};
+
+struct QueueStats
+{
+  uint32_t Pushed;
+  uint32_t Dropped;           // Rejected or overwritten when full
+  uint32_t Decimated;         // Skipped by QUEUE_DECIMATE
+  uint32_t HighWater;         // Most items ever queued
+};
+
+template <typename T, uint32_t Capacity>
+class BoundedQueue
+{
+  static_assert(Capacity >= 2, "Capacity must be at least two");
+
+public:
+  explicit BoundedQueue(E_QUEUE_POLICY Policy) : Policy(Policy) {}
+
+  // False when the item was not queued, or pushed out an older one
+  bool Push(const T& Item)
+  {
+    Stats.Pushed++;
+
+    if (Policy == QUEUE_DECIMATE && Size >= Capacity / 2)
+    {
+      if (++Skipped < QUEUE_DECIMATE_FACTOR)
+      {
+        Stats.Decimated++;
+        return false;
+      }
+      Skipped = 0;
+    }
+
+    bool Queued = true;
+    if (Size == Capacity)
+    {
+      Stats.Dropped++;
+      if (Policy != QUEUE_DROP_OLDEST) return false;
+
+      Tail = (Tail + 1) % Capacity;
+      Size--;
+      Queued = false;
+    }
+
+    Items[(Tail + Size) % Capacity] = Item;
+    Size++;
+    if (Size > Stats.HighWater) Stats.HighWater = Size;
+    return Queued;
+  }
+
+  bool Pop(T& Item)
+  {
+    if (Size == 0) return false;
+
+    Item = Items[Tail];
+    Tail = (Tail + 1) % Capacity;
+    Size--;
+    if (Size < Capacity / 2) Skipped = 0;
+    return true;
+  }
+
+  uint32_t Count(void) const { return Size; }
+  uint32_t GetCapacity(void) const { return Capacity; }
+  E_QUEUE_POLICY GetPolicy(void) const { return Policy; }
+  const QueueStats& GetStats(void) const { return Stats; }
+
+private:
+  T Items[Capacity];
+  uint32_t Tail = 0;
+  uint32_t Size = 0;
+  uint32_t Skipped = 0;
+  E_QUEUE_POLICY Policy;
+  QueueStats Stats = {};
+};
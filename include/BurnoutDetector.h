@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+/* End-of-burn detection
+*
+* Force is smoothed with a first order low pass whose coefficient follows the real
+* sample spacing. After the filtered force has reached the onset threshold, burnout
+* is confirmed once it has stayed below the burnout threshold for the whole hold-off.
+* A motor that never ignites never burns out; the caller's fixed window covers that.
+*/
+
+class BurnoutDetector
+{
+public:
+  BurnoutDetector(uint32_t TimeConstant, float OnsetThreshold, float BurnoutThreshold, uint32_t Holdoff)
+    : TimeConstant(TimeConstant), OnsetThreshold(OnsetThreshold), BurnoutThreshold(BurnoutThreshold), Holdoff(Holdoff) {}
+
+  void Reset(void);
+
+  // Returns true from the sample that confirms burnout on
+  bool Update(uint64_t Time, float Force);
+
+  float GetFiltered(void) const { return Filtered; }
+  bool IsIgnited(void) const { return Ignited; }
+  bool IsBurnedOut(void) const { return BurnedOut; }
+  uint64_t GetBurnoutTime(void) const { return BurnoutTime; }   // First sample of the quiet period
+
+private:
+  uint32_t TimeConstant;      // us
+  float OnsetThreshold;       // N
+  float BurnoutThreshold;     // N
+  uint32_t Holdoff;           // us
+
+  float Filtered = 0;
+  uint64_t PreviousTime = 0;
+  bool HasPrevious = false;
+  bool Ignited = false;
+  bool BurnedOut = false;
+  bool Below = false;
+  uint64_t BurnoutTime = 0;
+};
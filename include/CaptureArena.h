@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Whole-test capture arena
+*
+* A large append-only byte arena that holds log data while the motor burns so
+* nothing touches the card until POST_TEST. On the Teensy 4.1 it lives in EXTMEM
+* PSRAM, on host builds it is a plain heap allocation.
+*/
+
+#define CAPTURE_ARENA_SIZE              (1024ul * 1024ul)
+#define CAPTURE_WRITE_CHUNK             (32ul * 1024ul)   // Multi-block writes when emptying the arena
+
+class CaptureArena
+{
+public:
+  // Attaches the backing store. False when no PSRAM is fitted.
+  bool Begin(void);
+
+  // All or nothing, false when Size does not fit
+  bool Append(const void* Data, uint32_t Size);
+  void Clear(void) { Used = 0; }
+
+  bool IsAvailable(void) const { return Storage != nullptr; }
+  const uint8_t* GetData(void) const { return Storage; }
+  uint32_t GetUsed(void) const { return Used; }
+  uint32_t GetSize(void) const { return Size; }
+
+private:
+  uint8_t* Storage = nullptr;
+  uint32_t Size = 0;
+  uint32_t Used = 0;
+};
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#include "ThermistorAdc.h"
+
+/* Compile-time sensor channel registry
+*
+* A channel is a struct declaring where its value comes from, how often it is read,
+* how it is converted and its unit (Channels.h has the stand's list). The registry
+* lays the channels out back to back behind the record timestamp, so every offset is
+* a constant. The channel table in the log header, the telemetry layout frames and
+* the display rows are all generated from the same list.
+*
+* Analog channels are converted by Poll() at their own rate. Per sample, Fill()
+* copies those values in one block and converts only the load cell inputs.
+*/
+
+#define CHANNEL_NAME_SIZE               16
+#define CHANNEL_UNIT_SIZE               8
+#define CHANNEL_AGE_NONE                -1  // ADC_AGE until every analog channel has a reading
+
+enum E_CHANNEL_SOURCE : uint8_t {
+  CHANNEL_SOURCE_LOAD_CELL = 0,   // Every conversion makes a record, Convert() takes the whole sample
+  CHANNEL_SOURCE_ADC,             // Latest ThermistorAdc block, INPUT is the pin
+  CHANNEL_SOURCE_ADC_AGE          // us from the oldest analog value in the record to its time, CHANNEL_AGE_NONE before that
+};
+
+enum E_CHANNEL_TYPE : uint8_t {
+  CHANNEL_FLOAT32 = 0,
+  CHANNEL_INT32
+};
+
+template <typename T> struct ChannelType;
+template <> struct ChannelType<float> { static constexpr E_CHANNEL_TYPE VALUE = CHANNEL_FLOAT32; };
+template <> struct ChannelType<int32_t> { static constexpr E_CHANNEL_TYPE VALUE = CHANNEL_INT32; };
+
+// Describes one channel in the log header and the telemetry stream
+struct __attribute__((packed)) ChannelInfo
+{
+  constexpr ChannelInfo() : Name{}, Unit{}, Type(0), Source(0), Offset(0) {}
+  constexpr ChannelInfo(const char* Name, const char* Unit, E_CHANNEL_TYPE Type, E_CHANNEL_SOURCE Source, uint16_t Offset)
+    : Name{}, Unit{}, Type(Type), Source(Source), Offset(Offset)
+  {
+    for (uint8_t i = 0; i < CHANNEL_NAME_SIZE && Name[i] != 0; i++) this->Name[i] = Name[i];
+    for (uint8_t i = 0; i < CHANNEL_UNIT_SIZE && Unit[i] != 0; i++) this->Unit[i] = Unit[i];
+  }
+
+  char Name[CHANNEL_NAME_SIZE];   // Zero padded, not terminated when full
+  char Unit[CHANNEL_UNIT_SIZE];
+  uint8_t Type;               // E_CHANNEL_TYPE
+  uint8_t Source;             // E_CHANNEL_SOURCE
+  uint16_t Offset;            // Bytes from the start of the record
+};
+
+static_assert(sizeof(ChannelInfo) == 28, "ChannelInfo layout changed");
+
+template <uint16_t DataSize>
+struct __attribute__((packed)) ChannelRecord
+{
+  uint64_t Time;              // us since boot, when the load cell sample was converted
+  uint8_t Data[DataSize];     // Channel values, ChannelInfo::Offset - sizeof(Time)
+};
+
+struct ChannelPins
+{
+  uint8_t Pin[THERMISTOR_ADC_CHANNELS];
+  uint8_t Count;
+};
+
+// Layout helpers, evaluated at compile time for the registry below
+
+template <typename Channel, typename... Channels>
+constexpr uint8_t ChannelIndexOf(void)
+{
+  constexpr bool Same[] = { std::is_same<Channel, Channels>::value... };
+  for (uint8_t i = 0; i < sizeof...(Channels); i++)
+  {
+    if (Same[i]) return i;
+  }
+  return sizeof...(Channels);
+}
+
+// Bytes from the start of the record to channel Index
+template <typename... Channels>
+constexpr uint16_t ChannelOffsetAt(uint8_t Index)
+{
+  constexpr uint16_t Sizes[] = { sizeof(typename Channels::Type)... };
+  uint16_t Offset = sizeof(uint64_t);
+  for (uint8_t i = 0; i < Index; i++) Offset += Sizes[i];
+  return Offset;
+}
+
+// ADC channels ahead of channel Index, which is also its ThermistorAdc channel
+template <typename... Channels>
+constexpr uint8_t ChannelAdcIndexAt(uint8_t Index)
+{
+  constexpr E_CHANNEL_SOURCE Sources[] = { Channels::SOURCE... };
+  uint8_t Count = 0;
+  for (uint8_t i = 0; i < Index; i++) Count += Sources[i] == CHANNEL_SOURCE_ADC;
+  return Count;
+}
+
+template <typename... Channels>
+constexpr uint32_t ChannelMaxAdcRate(void)
+{
+  constexpr E_CHANNEL_SOURCE Sources[] = { Channels::SOURCE... };
+  constexpr uint32_t Rates[] = { Channels::RATE... };
+  uint32_t Rate = 0;
+  for (uint8_t i = 0; i < sizeof...(Channels); i++)
+  {
+    if (Sources[i] == CHANNEL_SOURCE_ADC && Rates[i] > Rate) Rate = Rates[i];
+  }
+  return Rate;
+}
+
+template <typename... Channels>
+constexpr bool ChannelAdcRatesDivide(void)
+{
+  constexpr E_CHANNEL_SOURCE Sources[] = { Channels::SOURCE... };
+  constexpr uint32_t Rates[] = { Channels::RATE... };
+  for (uint8_t i = 0; i < sizeof...(Channels); i++)
+  {
+    if (Sources[i] == CHANNEL_SOURCE_ADC && (Rates[i] == 0 || ChannelMaxAdcRate<Channels...>() % Rates[i] != 0)) return false;
+  }
+  return true;
+}
+
+template <typename... Channels>
+constexpr ChannelPins ChannelAdcPins(void)
+{
+  constexpr E_CHANNEL_SOURCE Sources[] = { Channels::SOURCE... };
+  constexpr uint8_t Inputs[] = { Channels::INPUT... };
+  ChannelPins Pins{};
+  for (uint8_t i = 0; i < sizeof...(Channels) && Pins.Count < THERMISTOR_ADC_CHANNELS; i++)
+  {
+    if (Sources[i] == CHANNEL_SOURCE_ADC) Pins.Pin[Pins.Count++] = Inputs[i];
+  }
+  return Pins;
+}
+
+template <typename... Channels>
+class ChannelRegistry
+{
+public:
+  static constexpr uint8_t COUNT = sizeof...(Channels);
+  static constexpr uint8_t ADC_COUNT = ChannelAdcIndexAt<Channels...>(COUNT);
+  static constexpr uint16_t DATA_SIZE = ChannelOffsetAt<Channels...>(COUNT) - sizeof(uint64_t);
+  static constexpr uint32_t POLL_RATE = ChannelMaxAdcRate<Channels...>();   // Hz Poll() has to run at
+  static constexpr ChannelPins ADC_PINS = ChannelAdcPins<Channels...>();
+
+  typedef ChannelRecord<DATA_SIZE> Record;
+
+  // Log header and telemetry layout, in record order
+  static constexpr ChannelInfo INFO[] = { ChannelInfo(Channels::NAME, Channels::UNIT, ChannelType<typename Channels::Type>::VALUE,
+    Channels::SOURCE, ChannelOffsetAt<Channels...>(ChannelIndexOf<Channels, Channels...>()))... };
+
+  // Display text per channel, nullptr when it is not shown
+  static constexpr const char* LABELS[] = { Channels::LABEL... };
+
+  static_assert(ADC_COUNT >= 1 && ADC_COUNT <= THERMISTOR_ADC_CHANNELS, "ThermistorAdc converts 1 to THERMISTOR_ADC_CHANNELS pins");
+  static_assert(ChannelAdcRatesDivide<Channels...>(), "Every analog channel rate must divide the fastest one");
+
+  template <typename Channel>
+  static constexpr uint8_t IndexOf(void) { return ChannelIndexOf<Channel, Channels...>(); }
+
+  template <typename Channel>
+  static typename Channel::Type Get(const Record& In)
+  {
+    static_assert(IndexOf<Channel>() < COUNT, "Channel is not registered");
+    typename Channel::Type Value;
+    memcpy(&Value, In.Data + ChannelOffsetAt<Channels...>(IndexOf<Channel>()) - sizeof(In.Time), sizeof(Value));
+    return Value;
+  }
+
+  template <typename Channel>
+  static void Set(Record& Out, typename Channel::Type Value)
+  {
+    static_assert(IndexOf<Channel>() < COUNT, "Channel is not registered");
+    memcpy(Out.Data + ChannelOffsetAt<Channels...>(IndexOf<Channel>()) - sizeof(Out.Time), &Value, sizeof(Value));
+  }
+
+  // Any channel as float, for display and reports
+  static float GetFloat(const Record& In, uint8_t Index)
+  {
+    const uint8_t* Data = In.Data + INFO[Index].Offset - sizeof(In.Time);
+    if (INFO[Index].Type == CHANNEL_INT32)
+    {
+      int32_t Value;
+      memcpy(&Value, Data, sizeof(Value));
+      return float(Value);
+    }
+    float Value;
+    memcpy(&Value, Data, sizeof(Value));
+    return Value;
+  }
+
+  void Begin(ThermistorAdc& Adc)
+  {
+    Adc.Begin(ADC_PINS.Pin, ADC_PINS.Count);
+  }
+
+  // Converts every analog channel that is due, call at POLL_RATE
+  void Poll(const ThermistorAdc& Adc)
+  {
+    int Expand[] = { (PollChannel<Channels>(Adc, std::integral_constant<E_CHANNEL_SOURCE, Channels::SOURCE>()), 0)... };
+    (void) Expand;
+    Polls++;
+
+    OldestAdcTime = AdcTime[0];
+    for (uint8_t i = 1; i < ADC_COUNT; i++)
+    {
+      if (AdcTime[i] < OldestAdcTime) OldestAdcTime = AdcTime[i];
+    }
+  }
+
+  // TSample has the conversion Time, load cell channels convert the rest
+  template <typename TSample>
+  void Fill(Record& Out, const TSample& Sample) const
+  {
+    Out = Latest;
+    Out.Time = Sample.Time;
+    int Expand[] = { (FillChannel<Channels>(Out, Sample, std::integral_constant<E_CHANNEL_SOURCE, Channels::SOURCE>()), 0)... };
+    (void) Expand;
+  }
+
+private:
+  template <typename Channel>
+  void PollChannel(const ThermistorAdc& Adc, std::integral_constant<E_CHANNEL_SOURCE, CHANNEL_SOURCE_ADC>)
+  {
+    constexpr uint8_t Index = ChannelAdcIndexAt<Channels...>(IndexOf<Channel>());
+    if (Polls % (POLL_RATE / Channel::RATE) != 0) return;
+
+    ThermistorAdcReading Reading = Adc.GetLatest(Index);
+    Set<Channel>(Latest, Channel::Convert(Reading.Code));
+    AdcTime[Index] = Reading.Time;
+  }
+
+  template <typename Channel, E_CHANNEL_SOURCE Source>
+  void PollChannel(const ThermistorAdc&, std::integral_constant<E_CHANNEL_SOURCE, Source>) {}
+
+  template <typename Channel, typename TSample>
+  static void FillChannel(Record& Out, const TSample& Sample, std::integral_constant<E_CHANNEL_SOURCE, CHANNEL_SOURCE_LOAD_CELL>)
+  {
+    Set<Channel>(Out, Channel::Convert(Sample));
+  }
+
+  template <typename Channel, typename TSample>
+  void FillChannel(Record& Out, const TSample& Sample, std::integral_constant<E_CHANNEL_SOURCE, CHANNEL_SOURCE_ADC_AGE>) const
+  {
+    // A time of 0 is a channel with no block yet. A block can also complete after the
+    // sample was taken and before it was filled, which is no age rather than a negative one.
+    int32_t Age = CHANNEL_AGE_NONE;
+    if (OldestAdcTime != 0)
+    {
+      uint64_t Elapsed = Sample.Time > OldestAdcTime ? Sample.Time - OldestAdcTime : 0;
+      Age = Elapsed > INT32_MAX ? INT32_MAX : int32_t(Elapsed);
+    }
+    Set<Channel>(Out, Age);
+  }
+
+  template <typename Channel, typename TSample>
+  static void FillChannel(Record&, const TSample&, std::integral_constant<E_CHANNEL_SOURCE, CHANNEL_SOURCE_ADC>) {}
+
+  Record Latest = {};         // Analog values as of the last Poll()
+  uint64_t AdcTime[ADC_COUNT] = {};
+  uint64_t OldestAdcTime = 0;
+  uint32_t Polls = 0;
+};
+
+template <typename... Channels> constexpr ChannelPins ChannelRegistry<Channels...>::ADC_PINS;
+template <typename... Channels> constexpr ChannelInfo ChannelRegistry<Channels...>::INFO[];
+template <typename... Channels> constexpr const char* ChannelRegistry<Channels...>::LABELS[];
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "ChannelRegistry.h"
+#include "Config.h"
+
+/* Sensor channels of the stand
+*
+* The record, the log header, the telemetry layout and the display rows follow this
+* list. Each channel names its source and input, the rate of analog channels, its
+* conversion and unit, and the display label (nullptr keeps it off the display).
+* Channels are appended at the end so older tools still find the first ones.
+*/
+
+// One conversion of every load cell, each one makes a record
+struct LoadCellSample
+{
+  uint64_t Time;              // ClockMicros() when the cells were read
+  float Force;                // N, all cells together
+  float Filtered;             // N, Force after the filter stage
+  float Cells[LOAD_CELL_COUNT];   // N per cell
+};
+
+struct ForceChannel
+{
+  typedef float Type;
+  static constexpr E_CHANNEL_SOURCE SOURCE = CHANNEL_SOURCE_LOAD_CELL;
+  static constexpr uint8_t INPUT = 0;
+  static constexpr uint32_t RATE = 0;   // Every conversion
+  static constexpr const char* NAME = "Force";
+  static constexpr const char* UNIT = "N";
+  static constexpr const char* LABEL = "Load Cell";
+  static float Convert(const LoadCellSample& Sample) { return Sample.Force; }
+};
+
+struct FilteredForceChannel
+{
+  typedef float Type;
+  static constexpr E_CHANNEL_SOURCE SOURCE = CHANNEL_SOURCE_LOAD_CELL;
+  static constexpr uint8_t INPUT = 0;
+  static constexpr uint32_t RATE = 0;
+  static constexpr const char* NAME = "Force Filtered";
+  static constexpr const char* UNIT = "N";
+  static constexpr const char* LABEL = "Filtered";
+  static float Convert(const LoadCellSample& Sample) { return Sample.Filtered; }
+};
+
+constexpr const char* LOAD_CELL_NAMES[] = { "Force #1", "Force #2", "Force #3", "Force #4" };
+constexpr const char* LOAD_CELL_LABELS[] = { "Cell #1", "Cell #2", "Cell #3", "Cell #4" };
+
+// Share of one cell, registered when there is more than one
+template <uint8_t Cell>
+struct LoadCellChannel
+{
+  typedef float Type;
+  static constexpr E_CHANNEL_SOURCE SOURCE = CHANNEL_SOURCE_LOAD_CELL;
+  static constexpr uint8_t INPUT = Cell;
+  static constexpr uint32_t RATE = 0;
+  static constexpr const char* NAME = LOAD_CELL_NAMES[Cell];
+  static constexpr const char* UNIT = "N";
+  static constexpr const char* LABEL = LOAD_CELL_LABELS[Cell];
+  static float Convert(const LoadCellSample& Sample) { return Sample.Cells[Cell]; }
+};
+
+struct Thermistor1Channel
+{
+  typedef float Type;
+  static constexpr E_CHANNEL_SOURCE SOURCE = CHANNEL_SOURCE_ADC;
+  static constexpr uint8_t INPUT = GPIO_THERMISTOR_1;
+  static constexpr uint32_t RATE = CHANNEL_THERMISTOR_RATE;
+  static constexpr const char* NAME = "Temperature #1";
+  static constexpr const char* UNIT = "*C";
+  static constexpr const char* LABEL = "Thermistor #1";
+  static float Convert(uint16_t Code);
+};
+
+struct Thermistor2Channel
+{
+  typedef float Type;
+  static constexpr E_CHANNEL_SOURCE SOURCE = CHANNEL_SOURCE_ADC;
+  static constexpr uint8_t INPUT = GPIO_THERMISTOR_2;
+  static constexpr uint32_t RATE = CHANNEL_THERMISTOR_RATE;
+  static constexpr const char* NAME = "Temperature #2";
+  static constexpr const char* UNIT = "*C";
+  static constexpr const char* LABEL = "Thermistor #2";
+  static float Convert(uint16_t Code);
+};
+
+struct TemperatureAgeChannel
+{
+  typedef int32_t Type;
+  static constexpr E_CHANNEL_SOURCE SOURCE = CHANNEL_SOURCE_ADC_AGE;
+  static constexpr uint8_t INPUT = 0;
+  static constexpr uint32_t RATE = 0;
+  static constexpr const char* NAME = "Temperature Age";
+  static constexpr const char* UNIT = "us";
+  static constexpr const char* LABEL = nullptr;
+};
+
+struct ChamberPressureChannel
+{
+  typedef float Type;
+  static constexpr E_CHANNEL_SOURCE SOURCE = CHANNEL_SOURCE_ADC;
+  static constexpr uint8_t INPUT = GPIO_PRESSURE_1;
+  static constexpr uint32_t RATE = CHANNEL_PRESSURE_RATE;
+  static constexpr const char* NAME = "Chamber Pressure";
+  static constexpr const char* UNIT = "bar";
+  static constexpr const char* LABEL = "Chamber";
+  static float Convert(uint16_t Code);
+};
+
+typedef ChannelRegistry<
+  ForceChannel,
+  Thermistor1Channel,
+  Thermistor2Channel,
+  TemperatureAgeChannel
+#if CHANNEL_CHAMBER_PRESSURE
+  , ChamberPressureChannel
+#endif
+#if FORCE_FILTER
+  , FilteredForceChannel
+#endif
+#if LOAD_CELL_COUNT > 1
+  , LoadCellChannel<0>, LoadCellChannel<1>
+#endif
+#if LOAD_CELL_COUNT > 2
+  , LoadCellChannel<2>
+#endif
+#if LOAD_CELL_COUNT > 3
+  , LoadCellChannel<3>
+#endif
+> SensorChannels;
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Monotonic 64-bit time base
+*
+* Extends the Cortex-M7 DWT cycle counter (wraps every ~7 s at 600 MHz) to 64 bits.
+* A 1 Hz IntervalTimer keeps the extension alive when nothing else reads the clock.
+* Safe to call from ISRs. Host builds run on the simulated clock in HalNative.cpp.
+*/
+
+void ClockBegin(void);
+uint64_t ClockCycles(void);
+uint64_t ClockMicros(void);
+
+inline uint64_t ClockMillis(void) { return ClockMicros() / 1000; }
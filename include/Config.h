@@ -0,0 +1,102 @@
+#pragma once
+
+/* Pre-Defined */
+
+// GPIO
+#define GPIO_THERMISTOR_1                     24
+#define GPIO_THERMISTOR_2                     25
+#define GPIO_PRESSURE_1                       15  // A1, ADC1 like the thermistors (A12/A13 are ADC2 only)
+#define GPIO_LOAD_CELL_SCK                    13
+#define GPIO_LOAD_CELL_DT                     6   // First cell, the others follow on the same port
+#define GPIO_LOAD_CELL_DT_2                   7
+#define GPIO_LOAD_CELL_DT_3                   8
+#define GPIO_LOAD_CELL_DT_4                   9
+#define GPIO_LOAD_CELL_RATE                   255 // HX711 RATE (HIGH = 80 SPS), 255 when hard-wired HIGH
+#define GPIO_RELAY_TOGGLE                     14
+#define GPIO_DISPLAY_SCL                      19
+#define GPIO_DISPLAY_SDA                      18
+#define GPIO_LED_TEST_ACTIVE                  32
+#define GPIO_BUTTON_ACTIVATE_TEST             33
+
+/* User Configurable */
+
+// Test config
+#define TEST_DATA_SAMPLE_RATE           50
+#define TEST_COUNTDOWN_SECONDS          30
+#define TEST_DURATION_SECONDS           15
+#define PRETRIGGER_SECONDS              5   // History before the start command that goes into the log
+#define LOAD_CELL_MAX_RATE              80  // HX711 SPS with RATE high, burst mode logs every conversion
+#define LOAD_CELL_SLOW_RATE             10  // HX711 SPS with RATE low, outside burst mode when GPIO_LOAD_CELL_RATE is wired
+#define PRETRIGGER_SAMPLE_RATE          LOAD_CELL_MAX_RATE  // The history holds every conversion
+
+// Task rates (Hz)
+#define TASK_LOAD_CELL_RATE             100 // Above the 80 SPS HX711 maximum
+#define TASK_STATE_RATE                 TEST_DATA_SAMPLE_RATE
+#define TASK_DISPLAY_RATE               50  // One render plus eight tile rows per frame
+#define TASK_TELEMETRY_RATE             200
+#define TASK_LOG_RATE                   TASK_LOAD_CELL_RATE
+#define TASK_LOAD_CELL_BURST_RATE       400
+#define TASK_ANALOG_BURST_RATE          400 // The analog task otherwise runs at SensorChannels::POLL_RATE
+
+// Channel config, Channels.h lists every channel (Hz for rates)
+#define CHANNEL_THERMISTOR_RATE         TEST_DATA_SAMPLE_RATE
+#define CHANNEL_CHAMBER_PRESSURE        0   // Pressure transducer on GPIO_PRESSURE_1
+#define CHANNEL_PRESSURE_RATE           TEST_DATA_SAMPLE_RATE
+
+// Force filter config (ForceFilter.h), the filtered force is logged next to the raw one
+#define FORCE_FILTER                    1
+#define FORCE_FILTER_TYPE               FORCE_FILTER_BIQUAD
+#define FORCE_FILTER_CUTOFF             10.0f // Hz, biquad and FIR
+#define FORCE_FILTER_LENGTH             9   // FIR taps or median window, odd
+#define FORCE_FILTER_SAMPLE_RATE        LOAD_CELL_MAX_RATE  // SPS of the test, the delay in the log and summary is for this rate
+
+// Analysis config
+#define ANALYSIS_ONSET_THRESHOLD        5.0f  // N, burn starts when force reaches this
+#define ANALYSIS_BURNOUT_THRESHOLD      2.0f  // N, burn ends when force falls below this
+
+// Burnout detection config, TEST_DURATION_SECONDS stays the upper limit
+#define BURNOUT_DETECTION               1
+#define BURNOUT_FILTER_TIME_CONSTANT    0.02f // s
+#define BURNOUT_ONSET_THRESHOLD         ANALYSIS_ONSET_THRESHOLD
+#define BURNOUT_THRESHOLD               ANALYSIS_BURNOUT_THRESHOLD
+#define BURNOUT_HOLDOFF_SECONDS         1.0f  // Quiet time before the test ends
+
+// Trigger config, burst mode runs from thrust onset to the end of the test
+#define TRIGGER_THRESHOLD               ANALYSIS_ONSET_THRESHOLD
+#define TRIGGER_CONFIRM_SAMPLES         2
+
+// Pipeline config, every sample is queued once per consumer (BoundedQueue.h)
+#define PIPELINE_LOG_DEPTH              64  // Samples
+#define PIPELINE_LOG_POLICY             QUEUE_DECIMATE    // A backlog costs resolution, not a gap in the impulse
+#define PIPELINE_TELEMETRY_DEPTH        32
+#define PIPELINE_TELEMETRY_POLICY       QUEUE_DROP_OLDEST // The control table wants the latest samples
+#define PIPELINE_DISPLAY_DEPTH          4
+#define PIPELINE_DISPLAY_POLICY         QUEUE_DROP_OLDEST
+
+// Event config, the button ISR only posts timestamped events that AppLoop() dispatches
+#define EVENT_QUEUE_DEPTH               8   // Power of two
+
+// Telemetry config
+#define TELEMETRY_STREAM                1   // Every load cell sample as a binary frame over USB serial
+#define TELEMETRY_LAYOUT_PERIOD         1000 // ms between channel layout repeats
+
+// Display config
+#define DISPLAY_REFRESH_RATE            5
+#define DISPLAY_BUS_CLOCK               400000
+#define DISPLAY_PAGE_SECONDS            2   // Per page of channel rows when they do not fit one
+
+// Recorder config
+#define RECORDER_PREALLOCATE            1   // Contiguous log file, no FAT updates during the test
+#define RECORDER_BENCHMARK              0   // Report SD write latency over the console at startup
+#define RECORDER_CAPTURE_PSRAM          1   // Hold the whole test in PSRAM, write it out in POST_TEST
+
+// Sensor calibration
+#define LOAD_CELL_COUNT                 1   // HX711s on GPIO_LOAD_CELL_SCK (1 to 4), read in lockstep
+#define LOAD_CELL_CALIBRATION_VALUE     1
+#define LOAD_CELL_ACQUISITION_INTERRUPT 1   // Capture every HX711 conversion on DOUT falling edge
+#define LOAD_CELL_SETTLE_TIME           400 // ms the HX711s convert before the startup tare
+#define THERMISTOR_1_RESISTANCE         19750
+#define THERMISTOR_2_RESISTANCE         18550
+#define THERMISTOR_CALIBRATION_OFFSET   40
+#define PRESSURE_1_ZERO_VOLTAGE         0.33f // V at 0 bar, after the divider
+#define PRESSURE_1_SCALE                40.0f // bar per V
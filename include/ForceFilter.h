@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Force filter stage
+*
+* Low passes the summed load cell force in blocks of samples. Three filters are
+* available: a biquad (RBJ low pass, Q = 1/sqrt(2)), a linear phase FIR (Hamming
+* windowed sinc) and a running median that removes spikes. The coefficients are
+* designed in Begin() for the conversion rate, run it again when the rate changes.
+* GetDelay() is the group delay at DC, so a feature of the filtered curve happens
+* that much earlier in the raw one.
+*
+* The biquad and FIR run through CMSIS-DSP in ForceFilterDsp.cpp (Teensy 4.x), the
+* scalar versions in ForceFilterScalar.cpp (host builds) use the same coefficients
+* and state layout. The median is shared.
+*/
+
+#define FORCE_FILTER_MAX_TAPS           31  // FIR length, odd
+#define FORCE_FILTER_MAX_MEDIAN         15  // Median window, odd
+#define FORCE_FILTER_BLOCK_SIZE         16  // Samples per Process() call at most
+#define FORCE_FILTER_MAX_CUTOFF         0.4f // Of the sample rate, Begin() clamps the cutoff to it
+
+enum E_FORCE_FILTER : uint8_t {
+  FORCE_FILTER_NONE = 0,      // Output is the input
+  FORCE_FILTER_BIQUAD,
+  FORCE_FILTER_FIR,
+  FORCE_FILTER_MEDIAN
+};
+
+class ForceFilter
+{
+public:
+  // Cutoff in Hz for the biquad and the FIR, Length is the FIR taps or the median window
+  void Begin(E_FORCE_FILTER Type, float SampleRate, float Cutoff, uint8_t Length);
+
+  // Back to rest, the next sample fills the history
+  void Reset(void);
+
+  // Count up to FORCE_FILTER_BLOCK_SIZE, In and Out may be the same buffer. Non-finite
+  // inputs are replaced by the last finite one.
+  void Process(const float* In, float* Out, uint32_t Count);
+
+  E_FORCE_FILTER GetType(void) const { return Type; }
+  float GetDelay(void) const { return Delay; }   // Samples
+  uint32_t GetDelayTime(void) const { return uint32_t(Delay * 1e6f / SampleRate + 0.5f); }   // us at the design rate
+
+  static const char* TypeName(E_FORCE_FILTER Type);
+
+private:
+  // Implemented by the backend
+  void ProcessBiquad(const float* In, float* Out, uint32_t Count);
+  void ProcessFir(const float* In, float* Out, uint32_t Count);
+
+  void ProcessMedian(const float* In, float* Out, uint32_t Count);
+
+  E_FORCE_FILTER Type = FORCE_FILTER_NONE;
+  float SampleRate = 1.0f;
+  uint8_t Length = 1;
+  float Delay = 0.0f;
+  bool Primed = false;
+  float LastFinite = 0.0f;
+
+  // Biquad: b0, b1, b2, -a1, -a2 (CMSIS-DSP order). FIR: taps, time reversed.
+  float Coefficients[FORCE_FILTER_MAX_TAPS] = {};
+
+  // Biquad: x[n-1], x[n-2], y[n-1], y[n-2]. FIR: the last Length - 1 inputs, then room for a block.
+  float State[FORCE_FILTER_MAX_TAPS + FORCE_FILTER_BLOCK_SIZE - 1] = {};
+
+  // Median: input history as a ring, and the same values kept sorted
+  float History[FORCE_FILTER_MAX_MEDIAN] = {};
+  float Sorted[FORCE_FILTER_MAX_MEDIAN] = {};
+  uint8_t Oldest = 0;
+};
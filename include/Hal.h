@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Hardware abstraction layer
+*
+* Everything the firmware core needs from the board goes through here.
+* src/hal/HalTeensy.cpp maps it onto the Teensy core, SdFat and U8g2,
+* src/hal/HalNative.cpp provides simulated backends for host builds (HalSim.h).
+* Time comes from Clock.h, the thermistor ADC from ThermistorAdc.h.
+*/
+
+#define HAL_MAX_FILES                   4
+
+// Output sink shared by the console and files
+class HalPrint
+{
+public:
+  virtual size_t Write(const void* Data, size_t Size) = 0;
+
+  size_t Print(const char* Text);
+  size_t Println(const char* Text = "");
+  size_t Printf(const char* Format, ...) __attribute__((format(printf, 2, 3)));
+
+protected:
+  ~HalPrint() = default;
+};
+
+// Console
+void HalConsoleBegin(uint32_t Baud);
+HalPrint& HalConsole(void);
+size_t HalConsoleWriteAvailable(void);   // Bytes that can be written right now without blocking
+
+// GPIO
+enum E_HAL_PIN_MODE : uint8_t {
+  HAL_INPUT = 0,
+  HAL_OUTPUT = 1
+};
+
+enum E_HAL_INTERRUPT : uint8_t {
+  HAL_INTERRUPT_RISING = 0,
+  HAL_INTERRUPT_FALLING = 1,
+  HAL_INTERRUPT_HIGH = 2
+};
+
+void HalPinMode(uint8_t Pin, E_HAL_PIN_MODE Mode);
+void HalDigitalWrite(uint8_t Pin, bool Level);
+bool HalDigitalRead(uint8_t Pin);
+void HalAttachInterrupt(uint8_t Pin, void (*Isr)(void), E_HAL_INTERRUPT Mode);
+uint32_t HalRandom(uint32_t Max);
+
+// File system
+bool HalFsBegin(void);
+bool HalFsExists(const char* Name);
+bool HalFsRemove(const char* Name);
+
+class HalFile : public HalPrint
+{
+public:
+  // Opens for writing, creating or truncating the file
+  bool Open(const char* Name);
+  bool Close(void);
+  bool IsOpen(void) const { return Slot >= 0; }
+
+  size_t Write(const void* Data, size_t Size) override;
+  bool Sync(void);
+  bool SeekSet(uint32_t Position);
+  bool Truncate(uint32_t Length);
+  bool PreAllocate(uint32_t Length);   // Contiguous, only on an empty file
+  uint32_t GetPosition(void) const;
+
+private:
+  int8_t Slot = -1;
+};
+
+// Load cells (HX711s sharing GPIO_LOAD_CELL_SCK, Hx711Array.h)
+#define HAL_LOAD_CELLS                  4
+
+// One DOUT pin per cell. False when the startup tare timed out.
+bool HalLoadCellBegin(const uint8_t* DataPins, uint8_t Count, uint32_t SettleTime, float CalibrationFactor);
+bool HalLoadCellUpdate(void);         // True when every cell was read, ISR safe
+float HalLoadCellGetData(uint8_t Cell);
+void HalLoadCellTare(void);
+
+// Display (128x64, 8 tile rows of 128 bytes)
+enum E_HAL_FONT : uint8_t {
+  HAL_FONT_SMALL = 0,
+  HAL_FONT_LARGE = 1
+};
+
+void HalDisplayBegin(uint32_t BusClock);
+void HalDisplayClear(void);
+void HalDisplaySetFont(E_HAL_FONT Font);
+void HalDisplayDrawHLine(uint8_t x, uint8_t y, uint8_t Width);
+void HalDisplayDrawStr(uint8_t x, uint8_t y, const char* Text);
+uint8_t HalDisplayGetTileRows(void);
+void HalDisplaySendTileRow(uint8_t Row);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Hal.h"
+#include "ThermistorAdcSim.h"
+
+/* Simulated board for host builds
+*
+* Time only moves when the driver calls HalSimAdvanceTo(). On the way every device
+* event that falls due runs at its exact time: HX711 conversions pull every DOUT low
+* and fire their interrupts, the thermistor ADC completes DMA blocks. Files live in RAM.
+*/
+
+#define HAL_SIM_CPU_MHZ                 600     // ClockCycles() per us
+#define HAL_SIM_LOAD_CELL_FIXED_RATE    80      // SPS of a hard-wired HX711 RATE pin
+#define HAL_SIM_LOAD_CELL_TARE_SAMPLES  16      // Conversions averaged by the startup tare
+#define HAL_SIM_ADC_BLOCK_TIME          2000    // us per thermistor ADC block
+#define HAL_SIM_THERMISTOR_CODE         2048    // Default raw ADC conversion
+#define HAL_SIM_FILE_BLOCK_SIZE         512     // Unit of HalSimSetFileTiming() costs
+#define HAL_SIM_CONSOLE_BUFFER_SIZE     4096    // USB serial TX buffering
+#define HAL_SIM_PIN_CHANGES             4       // Scheduled input changes pending at once
+
+// Force on load cell Cell in N, the cells together carry the thrust
+typedef float (*HalSimForceSource)(uint64_t Time, uint8_t Cell, void* Context);
+
+// Receives everything written to the console
+typedef void (*HalSimConsoleSink)(const void* Data, size_t Size, void* Context);
+
+// Runs every event up to Time, then leaves the clock there
+void HalSimAdvanceTo(uint64_t Time);
+
+// Time of the next device event, UINT64_MAX when none is scheduled
+uint64_t HalSimNextEvent(void);
+
+void HalSimSetLoadCellSource(HalSimForceSource Source, void* Context);
+void HalSimSetThermistorSource(ThermistorAdcSource Source, void* Context);
+
+// The HX711s stop converting for Duration us from Start, DOUT stays high
+void HalSimSetLoadCellStall(uint64_t Start, uint64_t Duration);
+
+// Every file write or sync busy-waits BlockTime us per started block, and until the end
+// of the stall window when it starts inside it. Interrupts keep firing meanwhile.
+void HalSimSetFileTiming(uint32_t BlockTime, uint64_t StallStart, uint64_t StallDuration);
+
+// Whether the capture arena finds PSRAM, fitted by default
+void HalSimSetPsram(bool Fitted);
+bool HalSimHasPsram(void);
+
+// Console output goes to Sink, or to stdout while it is nullptr (the default)
+void HalSimSetConsoleSink(HalSimConsoleSink Sink, void* Context);
+
+// The host reads BytesPerSecond, HalConsoleWriteAvailable() shrinks while it falls
+// behind. 0 (the default) reads everything at once.
+void HalSimSetConsoleRate(uint32_t BytesPerSecond);
+
+// Heap allocations since start (malloc family and operator new), not counting the
+// simulator's own files and console
+uint64_t HalSimAllocations(void);
+
+// Drives an input, firing its interrupt on a matching edge
+void HalSimSetPin(uint8_t Pin, bool Level);
+bool HalSimGetPin(uint8_t Pin);
+
+// Drives an input at Time as a device event, so its interrupt can land in the middle
+// of a task. False when HAL_SIM_PIN_CHANGES are already pending.
+bool HalSimSchedulePin(uint8_t Pin, bool Level, uint64_t Time);
+
+// nullptr when the file does not exist
+const uint8_t* HalSimReadFile(const char* Name, uint32_t* Size);
+
+// Writes every file into Directory, returns the number written
+uint32_t HalSimDumpFiles(const char* Directory);
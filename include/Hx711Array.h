@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+
+/* HX711 bridges read in lockstep
+*
+* Every HX711 shares the one SCK line and has its own DOUT. Run from the same clock
+* (one crystal, the others fed through XI) they finish their conversions together.
+* Once every DOUT is low, a single sequence of 25 pulses clocks all of them out. Each
+* pulse samples every DOUT at once into a bit mask, and Decode() transposes the masks
+* into one code per cell afterwards, so a conversion costs about as much as with one
+* cell.
+*
+* The backend supplies the pins through a port (HalTeensy.cpp on the target, a
+* memory port in the benchmarks). Decoding, tare and calibration live here.
+*/
+
+#define HX711_CELLS                     4   // Most DOUT lines on one SCK
+#define HX711_DATA_BITS                 24
+#define HX711_GAIN_PULSES               1   // After the data: channel A, gain 128 next
+#define HX711_TARE_SAMPLES              16  // Conversions averaged by Tare()
+
+// DOUT levels during one pulse, bit c is cell c
+typedef uint8_t Hx711Levels;
+
+class Hx711Array
+{
+public:
+  void Begin(uint8_t Count, float CalibrationFactor);
+
+  // Clocks one conversion out of every cell once all of them are ready. TPort has
+  // Hx711Levels Read(), Clock(bool Level) and Wait() for half an SCK period. SCK high
+  // for 60 us powers the HX711s down, so no interrupt may stretch the sequence.
+  template <typename TPort>
+  bool Update(TPort& Port)
+  {
+    if ((Port.Read() & ReadyMask) != 0) return false;
+
+    Hx711Levels Levels[HX711_DATA_BITS];
+    for (uint8_t i = 0; i < HX711_DATA_BITS; i++)
+    {
+      Port.Clock(true);
+      Port.Wait();
+      Levels[i] = Port.Read();
+      Port.Clock(false);
+      Port.Wait();
+    }
+    for (uint8_t i = 0; i < HX711_GAIN_PULSES; i++)
+    {
+      Port.Clock(true);
+      Port.Wait();
+      Port.Clock(false);
+      Port.Wait();
+    }
+
+    Decode(Levels);
+    return true;
+  }
+
+  // Levels of the HX711_DATA_BITS pulses, MSB first
+  void Decode(const Hx711Levels* Levels);
+
+  // Averages the next HX711_TARE_SAMPLES conversions into the zero of every cell
+  void Tare(void);
+  bool IsTaring(void) const { return TareLeft != 0; }
+
+  uint8_t GetCount(void) const { return Count; }
+  int32_t GetCode(uint8_t Cell) const { return Codes[Cell]; }
+
+  // Counts above the zero over the calibration factor
+  float GetData(uint8_t Cell) const { return float(Codes[Cell] - Offsets[Cell]) / CalibrationFactor; }
+
+private:
+  int32_t Codes[HX711_CELLS] = {};
+  int32_t Offsets[HX711_CELLS] = {};
+  int64_t TareSums[HX711_CELLS] = {};
+  float CalibrationFactor = 1.0f;
+  uint8_t Count = 1;
+  Hx711Levels ReadyMask = 1;
+  uint8_t TareLeft = 0;
+};
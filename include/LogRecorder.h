@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Channels.h"
+#include "Hal.h"
+
+/* Binary log format
+*
+* A log file is one LogFileHeader, the ChannelInfo of every channel, back-to-back
+* LogRecords and, when the test was closed normally, one LogFileTrailer with the
+* pipeline accounting. The channel table describes the record layout, so
+* tools/decode_log.py converts any channel set back into the CSV layout.
+*/
+
+#define LOG_FILE_MAGIC                  0x4C545354  // "TSTL"
+#define LOG_FILE_VERSION                5
+#define LOG_TRAILER_MAGIC               0x444E4554  // "TEND"
+
+// Recorder config
+#define RECORDER_BLOCK_SIZE             512
+#define RECORDER_BUFFER_SIZE            (16 * RECORDER_BLOCK_SIZE)
+
+struct __attribute__((packed)) LogFileHeader
+{
+  uint32_t Magic;
+  uint16_t Version;
+  uint16_t RecordSize;
+  uint16_t SampleRate;        // Hz outside burst mode only, place records by their Time
+  uint16_t TrailerSize;
+  uint16_t ChannelCount;      // ChannelInfo entries right after the header
+  uint8_t FilterType;         // E_FORCE_FILTER behind the "Force Filtered" channel
+  uint8_t Reserved;
+  uint32_t FilterDelay;       // us the filtered force lags the raw one
+};
+
+typedef SensorChannels::Record LogRecord;
+
+// Header plus channel table, where the first record starts
+constexpr uint32_t LOG_HEADER_SIZE = sizeof(LogFileHeader) + SensorChannels::COUNT * sizeof(ChannelInfo);
+
+// Consumers of the sample pipeline, in trailer order
+enum E_LOG_CONSUMER : uint8_t {
+  LOG_CONSUMER_LOG = 0,
+  LOG_CONSUMER_TELEMETRY,
+  LOG_CONSUMER_DISPLAY,
+  LOG_CONSUMER_COUNT
+};
+
+struct __attribute__((packed)) LogConsumerStats
+{
+  uint32_t Pushed;
+  uint32_t Dropped;           // Lost to a full queue
+  uint32_t Decimated;         // Skipped by QUEUE_DECIMATE
+  uint32_t HighWater;         // Deepest backlog, samples
+  uint32_t MaxAge;            // us from conversion until the consumer took a sample
+  uint8_t Policy;             // E_QUEUE_POLICY
+  uint8_t Reserved[3];
+};
+
+struct __attribute__((packed)) LogFileTrailer
+{
+  uint32_t Magic;
+  uint32_t AcquisitionDropped;  // Conversions lost before the pipeline
+  uint32_t RecorderDropped;     // Pushes the SD ring had no room for
+  uint32_t TelemetryDropped;    // Frames the host did not take in time
+  LogConsumerStats Consumers[LOG_CONSUMER_COUNT];
+};
+
+// Size to preallocate for Records records, rounded up to whole blocks with 25% headroom
+constexpr uint32_t LogFileSize(uint32_t Records)
+{
+  return ((LOG_HEADER_SIZE + Records * sizeof(LogRecord) * 5 / 4)
+          / RECORDER_BLOCK_SIZE + 1) * RECORDER_BLOCK_SIZE;
+}
+
+static_assert(sizeof(LogFileHeader) == 20, "LogFileHeader layout changed");
+static_assert(sizeof(LogFileTrailer) == 16 + 24 * LOG_CONSUMER_COUNT, "LogFileTrailer layout changed");
+static_assert(RECORDER_BUFFER_SIZE % RECORDER_BLOCK_SIZE == 0, "Buffer must hold whole blocks");
+
+class LogRecorder
+{
+public:
+  // The file must already be positioned at BaseOffset
+  void Begin(HalFile* Target, uint32_t BaseOffset = 0);
+
+  // Copies into the RAM ring, never touches the card. Returns false and counts a drop when full.
+  bool Push(const void* Data, uint32_t Size);
+  bool Push(const LogRecord& Record) { return Push(&Record, sizeof(Record)); }
+
+  // Writes pending data in block-aligned chunks, only whole blocks
+  void Drain(void);
+
+  // Writes everything pending and syncs. Only call at state transitions.
+  void Flush(void);
+
+  uint32_t GetPending(void) const { return Head - Tail; }
+  uint32_t GetDropped(void) const { return Dropped; }
+  uint32_t GetFileOffset(void) const { return Tail; }
+
+private:
+  void WriteChunk(uint32_t Size);
+
+  uint8_t Buffer[RECORDER_BUFFER_SIZE] __attribute__((aligned(4)));
+
+  // Free running byte counters starting at the base offset, index = counter % RECORDER_BUFFER_SIZE.
+  // Every byte goes through the ring, so Tail is also the file offset.
+  uint32_t Head = 0;
+  uint32_t Tail = 0;
+  uint32_t Dropped = 0;
+  HalFile* Target = nullptr;
+};
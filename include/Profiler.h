@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdint.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+/* Section profiler
+*
+* PROFILE_SCOPE(Section) times the rest of the enclosing block with the cycle counter
+* and folds the duration into min/max/mean and a log2-bucketed histogram. Recording
+* is a handful of instructions, cheap enough to stay on in production builds.
+*/
+
+#define PROFILER_ENABLED                1
+#define PROFILER_BUCKETS                32  // Bucket k holds durations in [2^k, 2^(k+1)) ticks
+
+enum E_PROFILE_SECTION : uint8_t {
+  PROFILE_LOAD_CELL_ISR = 0,
+  PROFILE_LOAD_CELL,
+  PROFILE_FORCE_FILTER,
+  PROFILE_ANALOG,
+  PROFILE_LOG_TEST_DATA,
+  PROFILE_RECORDER_DRAIN,
+  PROFILE_RECORDER_SYNC,
+  PROFILE_DISPLAY_RENDER,
+  PROFILE_DISPLAY_SEND,
+  PROFILE_STATE,
+  PROFILE_TELEMETRY,
+  PROFILE_SECTION_COUNT
+};
+
+struct ProfileStats
+{
+  uint32_t Count;
+  uint32_t Min;               // Ticks
+  uint32_t Max;
+  uint64_t Total;
+  uint32_t Histogram[PROFILER_BUCKETS];
+};
+
+// Ticks of the profiler time base
+inline uint32_t ProfilerNow(void)
+{
+#if defined(ARDUINO)
+  return ARM_DWT_CYCCNT;
+#else
+  return uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+inline uint32_t ProfilerTicksPerMicrosecond(void)
+{
+#if defined(ARDUINO)
+  return F_CPU_ACTUAL / 1000000;
+#else
+  return 1000;
+#endif
+}
+
+void ProfilerRecord(E_PROFILE_SECTION Section, uint32_t Ticks);
+void ProfilerReset(void);
+const ProfileStats& ProfilerGetStats(E_PROFILE_SECTION Section);
+const char* ProfilerGetName(E_PROFILE_SECTION Section);
+
+// Formats the report line by line and hands each line to Write
+typedef void (*ProfilerWriter)(const char* Line, void* Context);
+void ProfilerReport(ProfilerWriter Write, void* Context);
+
+class ProfileScope
+{
+public:
+  explicit ProfileScope(E_PROFILE_SECTION Section) : Section(Section), Start(ProfilerNow()) {}
+  ~ProfileScope() { ProfilerRecord(Section, ProfilerNow() - Start); }
+
+private:
+  E_PROFILE_SECTION Section;
+  uint32_t Start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if PROFILER_ENABLED
+#define PROFILE_SCOPE(Section) ProfileScope PROFILE_CONCAT(ProfileScope_, __LINE__)(Section)
+#else
+#define PROFILE_SCOPE(Section)
+#endif
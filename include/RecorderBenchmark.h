@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Hal.h"
+
+// Writes Size bytes in RECORDER_BLOCK_SIZE chunks to a scratch file, once growing the
+// file and once into a preallocated one, and prints per-block write latency to Out.
+void RecorderBenchmark(uint32_t Size, HalPrint& Out);
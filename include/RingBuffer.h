@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Fixed-size circular history
+*
+* Push() never fails: when full, the oldest item is overwritten. Pop() returns
+* items oldest first. Single context only, no locking.
+*/
+
+template <typename T, uint32_t Capacity>
+class RingBuffer
+{
+  static_assert(Capacity != 0, "Capacity must not be zero");
+
+public:
+  void Push(const T& Item)
+  {
+    Items[(Tail + Size) % Capacity] = Item;
+    if (Size == Capacity)
+    {
+      Tail = (Tail + 1) % Capacity;
+      Overwritten++;
+      return;
+    }
+    Size++;
+  }
+
+  bool Pop(T& Item)
+  {
+    if (Size == 0) return false;
+
+    Item = Items[Tail];
+    Tail = (Tail + 1) % Capacity;
+    Size--;
+    return true;
+  }
+
+  void Clear(void) { Tail = 0; Size = 0; }
+
+  uint32_t Count(void) const { return Size; }
+  uint32_t GetCapacity(void) const { return Capacity; }
+  uint32_t GetOverwritten(void) const { return Overwritten; }
+
+private:
+  T Items[Capacity];
+  uint32_t Tail = 0;
+  uint32_t Size = 0;
+  uint32_t Overwritten = 0;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Cooperative fixed-capacity scheduler
+*
+* Every task has its own period and priority. RunOnce() runs the highest priority
+* task that is due; tasks run to completion and never preempt each other. The time
+* source is a plain function so host builds can drive it with a fake clock.
+*
+* A deadline miss is a task finishing after its next release. Releases that were
+* missed entirely are skipped (not run back to back) and counted.
+*/
+
+#define SCHEDULER_MAX_TASKS             12
+
+typedef uint64_t (*SchedulerClock)(void);
+typedef void (*SchedulerFunction)(void);
+
+struct SchedulerTask
+{
+  const char* Name;
+  SchedulerFunction Function;
+  uint32_t Period;            // us
+  uint8_t Priority;           // Higher runs first
+  bool Enabled;
+  uint64_t NextRelease;       // us
+
+  // Accounting
+  uint32_t Runs;
+  uint32_t DeadlineMisses;
+  uint32_t SkippedReleases;
+  uint32_t MaxLateness;       // us from release to start
+};
+
+class Scheduler
+{
+public:
+  explicit Scheduler(SchedulerClock Clock) : Clock(Clock) {}
+
+  // Returns the task id, or -1 when the table is full
+  int8_t Add(const char* Name, SchedulerFunction Function, uint32_t Period, uint8_t Priority);
+  void SetPeriod(int8_t Id, uint32_t Period);
+  void SetEnabled(int8_t Id, bool Enabled);
+
+  // Runs at most one task. Returns false when nothing was due.
+  bool RunOnce(void);
+
+  // Earliest release of an enabled task, UINT64_MAX when there is none
+  uint64_t GetNextRelease(void) const;
+
+  uint8_t GetTaskCount(void) const { return TaskCount; }
+  const SchedulerTask& GetTask(uint8_t Id) const { return Tasks[Id]; }
+  void ResetStats(void);
+
+private:
+  SchedulerClock Clock;
+  SchedulerTask Tasks[SCHEDULER_MAX_TASKS] = {};
+  uint8_t TaskCount = 0;
+};
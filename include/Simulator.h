@@ -0,0 +1,128 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "App.h"
+#include "LogRecorder.h"
+
+/* Scripted test-sequence simulator (host builds)
+*
+* Runs the app from boot to POST_TEST on the simulated board. A scenario scripts
+* the thrust curve, temperatures, sensor noise, HX711 / SD stalls and how fast the
+* host reads the USB serial; afterwards the produced log and the telemetry stream are
+* decoded and checked against the script. Every run is deterministic
+* for a given scenario and seed.
+*
+* SimRun() boots the app, which only happens once per process, so the driver forks
+* for every scenario.
+*/
+
+#define SIM_BUTTON_PRESS_TIME           1.0f    // s after boot
+#define SIM_BUTTON_BOUNCE_TIME          100     // us the contact bounces before it settles
+#define SIM_BUTTON_HOLD_TIME            0.2f    // s
+#define SIM_START_LATENCY_LIMIT         1000    // us from the press to COUNTDOWN
+#define SIM_TIME_LIMIT                  120.0f  // s of virtual time before a run is abandoned
+#define SIM_DRAIN_TIME                  0.5f    // s the app keeps running in POST_TEST
+#define SIM_IMPULSE_TOLERANCE           0.03f   // Relative, plus the integrated noise
+#define SIM_COUNTDOWN_TOLERANCE         0.05f   // s
+#define SIM_BURNOUT_TOLERANCE           0.5f    // s past the burnout hold-off
+
+enum E_SIM_CURVE : uint8_t {
+  SIM_CURVE_NONE = 0,         // Misfire
+  SIM_CURVE_HALF_SINE,
+  SIM_CURVE_PROGRESSIVE,      // Linear rise to the peak, then cut off
+  SIM_CURVE_REGRESSIVE,       // Peak at ignition, linear decay
+  SIM_CURVE_TABLE             // Linear interpolation between Table points
+};
+
+// Times are s from the relay command unless noted
+struct SimScenario
+{
+  const char* Name;
+  uint32_t Seed;
+
+  // Thrust
+  E_SIM_CURVE Curve;
+  float PeakThrust;           // N
+  float IgnitionDelay;
+  float BurnTime;
+  const float (*Table)[2];    // { s from ignition, N }, ascending
+  uint8_t TableSize;
+  float ForceNoise;           // N rms
+
+  // Thermistors
+  float Temperature[2];       // *C at boot
+  float TemperatureRate[2];   // *C/s once the relay fires
+  float TemperatureNoise;     // *C rms
+
+  // Stalls
+  float LoadCellStallStart;
+  float LoadCellStallDuration;
+  uint32_t SdBlockTime;       // us per 512 byte block
+  float SdStallStart;
+  float SdStallDuration;
+  bool NoPsram;               // The log streams to SD during the test
+
+  // USB serial
+  uint32_t UsbRate;           // Bytes/s the host reads, 0 when unlimited
+};
+
+struct SimOptions
+{
+  const char* OutputDirectory;  // Produced files are written here unless nullptr
+  bool Verbose;                 // Prints the console text after the run
+  int TelemetryFd;              // Gets a copy of the raw console stream unless -1
+  bool Realtime;                // Paces virtual time to the wall clock
+};
+
+struct SimReport
+{
+  bool Passed;
+  char Failure[64];           // First failed check
+  E_OPERATION_STATE State;
+  double VirtualTime;         // s
+  double WallTime;            // s
+
+  // Produced log
+  uint32_t Records;
+  uint32_t LogBytes;
+  double MaxGap;              // s between consecutive records
+  double Impulse;             // Ns, trapezoid over the records from the relay command on
+  double ExpectedImpulse;     // Ns, from the script
+  double PeakThrust;          // N
+  LogFileTrailer Trailer;     // Pipeline accounting written by the app
+
+  // Sequence timing
+  uint32_t StartLatency;      // us from the button press to COUNTDOWN, as seen by the driver
+  double CountdownError;      // s, relay command against button press + countdown
+  double EndAfterBurnout;     // s, last record against the scripted burnout
+
+  // Pipeline, from the log trailer
+  uint32_t LogQueueLost;      // Dropped and decimated by the log consumer's queue
+
+  // Telemetry stream
+  uint32_t TelemetryFrames;
+  uint32_t TelemetryDropped;  // Sequence gaps
+
+  // Heap allocations by the app after AppSetup(), must stay 0
+  uint64_t HeapAllocations;
+
+  // Scheduler
+  uint32_t DeadlineMisses;
+  uint32_t SkippedReleases;
+  uint32_t MaxLateness;       // us, worst task
+  const char* WorstTask;
+};
+
+extern const SimScenario SIM_SCENARIOS[];
+extern const uint32_t SIM_SCENARIO_COUNT;
+
+// Reproducible random scenario for sweeps
+SimScenario SimRandomScenario(uint32_t Index, uint32_t Seed, char* Name, uint32_t NameSize);
+
+// Once per process
+void SimRun(const SimScenario& Scenario, SimReport& Report, const SimOptions& Options);
+
+void SimPrintReportHeader(FILE* Out);
+void SimPrintReport(FILE* Out, const SimScenario& Scenario, const SimReport& Report);
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+/* Lock-free single-producer/single-consumer queue
+*
+* Push() may run in an ISR while Pop() runs in loop(), or the other way round,
+* as long as each side has exactly one caller. Full queues drop the new item.
+*/
+
+template <typename T, uint32_t Capacity>
+class SpscQueue
+{
+  static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  // Producer side
+  bool Push(const T& Item)
+  {
+    uint32_t CurrentHead = Head.load(std::memory_order_relaxed);
+    if (CurrentHead - Tail.load(std::memory_order_acquire) == Capacity)
+    {
+      Dropped.store(Dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    Items[CurrentHead & (Capacity - 1)] = Item;
+    Head.store(CurrentHead + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side
+  bool Pop(T& Item)
+  {
+    uint32_t CurrentTail = Tail.load(std::memory_order_relaxed);
+    if (CurrentTail == Head.load(std::memory_order_acquire)) return false;
+
+    Item = Items[CurrentTail & (Capacity - 1)];
+    Tail.store(CurrentTail + 1, std::memory_order_release);
+    return true;
+  }
+
+  uint32_t Count(void) const { return Head.load(std::memory_order_acquire) - Tail.load(std::memory_order_acquire); }
+  uint32_t GetDropped(void) const { return Dropped.load(std::memory_order_relaxed); }
+
+private:
+  T Items[Capacity];
+  std::atomic<uint32_t> Head{0};
+  std::atomic<uint32_t> Tail{0};
+  std::atomic<uint32_t> Dropped{0};
+};
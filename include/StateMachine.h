@@ -0,0 +1,166 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Scheduler.h"
+
+/* Table-driven state machine
+*
+* The application describes its states and transitions in two constexpr tables.
+* Every state has entry, exit and update actions and the set of scheduler tasks
+* that run while it is active. A transition fires on a trigger from its From state
+* when its guard passes. The first matching row wins, so table order is priority.
+*
+* The state table is indexed by state, StateTableValid() and TransitionTableValid()
+* check both tables at compile time. Actions and guards are plain functions.
+*
+* Entries and the time spent per state as well as every transition taken are counted.
+*/
+
+typedef void (*StateAction)(void);
+typedef bool (*StateGuard)(void);
+
+constexpr uint32_t StateTask(int8_t Id) { return 1ul << Id; }
+
+template <typename TState>
+struct StateDefinition
+{
+  TState State;
+  const char* Name;
+  StateAction Entry;          // nullptr for none
+  StateAction Exit;
+  StateAction Update;         // On every Update() while active
+  uint32_t Tasks;             // StateTask() of every scheduler task that runs in this state
+};
+
+template <typename TState, typename TTrigger>
+struct StateTransition
+{
+  TState From;
+  TTrigger Trigger;
+  StateGuard Guard;           // nullptr always passes
+  StateAction Action;         // Runs between the exit and the entry action
+  TState To;
+};
+
+struct StateStats
+{
+  uint32_t Entries;
+  uint64_t Time;              // us, finished visits only
+};
+
+// Row i describes state i
+template <typename TState, uint8_t StateCount>
+constexpr bool StateTableValid(const StateDefinition<TState> (&States)[StateCount])
+{
+  for (uint8_t i = 0; i < StateCount; i++)
+  {
+    if (uint8_t(States[i].State) != i || States[i].Name == nullptr) return false;
+  }
+  return true;
+}
+
+// Every row starts and ends in a known state, and no row follows an unguarded one it would shadow
+template <typename TState, typename TTrigger, uint8_t TransitionCount>
+constexpr bool TransitionTableValid(const StateTransition<TState, TTrigger> (&Transitions)[TransitionCount], uint8_t StateCount)
+{
+  for (uint8_t i = 0; i < TransitionCount; i++)
+  {
+    if (uint8_t(Transitions[i].From) >= StateCount || uint8_t(Transitions[i].To) >= StateCount) return false;
+
+    for (uint8_t j = 0; j < i; j++)
+    {
+      if (Transitions[j].From == Transitions[i].From && Transitions[j].Trigger == Transitions[i].Trigger
+        && Transitions[j].Guard == nullptr) return false;
+    }
+  }
+  return true;
+}
+
+template <typename TState, typename TTrigger, uint8_t StateCount, uint8_t TransitionCount>
+class StateMachine
+{
+public:
+  typedef StateDefinition<TState> State;
+  typedef StateTransition<TState, TTrigger> Transition;
+
+  constexpr StateMachine(const State (&States)[StateCount], const Transition (&Transitions)[TransitionCount], Scheduler& Tasks,
+    SchedulerClock Clock) : States(States), Transitions(Transitions), Tasks(Tasks), Clock(Clock) {}
+
+  // Enters Initial without a transition
+  void Begin(TState Initial)
+  {
+    Enter(Initial, Clock());
+  }
+
+  // Takes the first transition out of the current state for Trigger whose guard passes.
+  // Time is when the trigger happened, the next state's time starts there. False when
+  // nothing fired.
+  bool Dispatch(TTrigger Trigger, uint64_t Time)
+  {
+    for (uint8_t i = 0; i < TransitionCount; i++)
+    {
+      const Transition& Row = Transitions[i];
+      if (Row.From != Current || Row.Trigger != Trigger) continue;
+      if (Row.Guard != nullptr && !Row.Guard()) continue;
+
+      if (Time < Entered) Time = Entered;
+      if (States[Current].Exit != nullptr) States[Current].Exit();
+      Stats[Current].Time += Time - Entered;
+      TransitionCounts[i]++;
+
+      if (Row.Action != nullptr) Row.Action();
+      Enter(Row.To, Time);
+      return true;
+    }
+    return false;
+  }
+
+  bool Dispatch(TTrigger Trigger) { return Dispatch(Trigger, Clock()); }
+
+  void Update(void)
+  {
+    if (States[Current].Update != nullptr) States[Current].Update();
+  }
+
+  TState GetState(void) const { return Current; }
+  const char* GetName(TState Id) const { return States[Id].Name; }
+  uint64_t GetEnteredTime(void) const { return Entered; }
+
+  uint32_t GetEntries(TState Id) const { return Stats[Id].Entries; }
+
+  // Including the current visit
+  uint64_t GetTime(TState Id) const
+  {
+    return Stats[Id].Time + (Id == Current ? Clock() - Entered : 0);
+  }
+
+  uint8_t GetTransitionCount(void) const { return TransitionCount; }
+  const Transition& GetTransition(uint8_t Index) const { return Transitions[Index]; }
+  uint32_t GetTaken(uint8_t Index) const { return TransitionCounts[Index]; }
+
+private:
+  void Enter(TState Id, uint64_t Time)
+  {
+    Current = Id;
+    Entered = Time;
+    Stats[Id].Entries++;
+
+    // Task set first, so the entry action may still adjust single tasks
+    for (uint8_t Task = 0; Task < Tasks.GetTaskCount(); Task++)
+    {
+      Tasks.SetEnabled(int8_t(Task), (States[Id].Tasks & StateTask(int8_t(Task))) != 0);
+    }
+    if (States[Id].Entry != nullptr) States[Id].Entry();
+  }
+
+  const State (&States)[StateCount];
+  const Transition (&Transitions)[TransitionCount];
+  Scheduler& Tasks;
+  SchedulerClock Clock;
+
+  TState Current = TState(0);
+  uint64_t Entered = 0;
+  StateStats Stats[StateCount] = {};
+  uint32_t TransitionCounts[TransitionCount] = {};
+};
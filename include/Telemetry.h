@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "ChannelRegistry.h"
+
+/* Live telemetry over the USB serial console
+*
+* Every frame is a TelemetryHeader, a payload and the CRC-32 (zlib) of both,
+* COBS encoded and wrapped in 0x00 delimiters:
+*
+*   0x00 | COBS(Header + Payload + CRC32) | 0x00
+*
+* Frames are queued in a RAM ring and Service() hands the console only as many
+* whole frames as it can take without blocking, so a slow or absent host costs
+* frames, never acquisition time. A dropped frame still uses up its sequence number.
+* Console text only ever lands between frames and is told apart by the receiver.
+*
+* A sample payload is the record's channel data followed by the E_OPERATION_STATE
+* byte, so a channel sits at ChannelInfo::Offset - 8. The layout is sent as one
+* TELEMETRY_CHANNEL frame per channel at boot and repeated for hosts that attach later.
+* tools/telemetry_receiver.py decodes the stream.
+*/
+
+#define TELEMETRY_BUFFER_SIZE           4096    // Power of two
+#define TELEMETRY_MAX_PAYLOAD           48
+#define TELEMETRY_MAX_RAW               (sizeof(TelemetryHeader) + TELEMETRY_MAX_PAYLOAD + 4)
+#define TELEMETRY_MAX_FRAME             (TELEMETRY_MAX_RAW + TELEMETRY_MAX_RAW / 254 + 3)
+
+enum E_TELEMETRY_TYPE : uint8_t {
+  TELEMETRY_SAMPLE = 1,         // Channel data + state
+  TELEMETRY_CHANNEL             // TelemetryChannel
+};
+
+struct __attribute__((packed)) TelemetryHeader
+{
+  uint8_t Type;
+  uint32_t Sequence;          // Per frame since boot, gaps are drops
+  uint64_t Time;              // us since boot
+};
+
+struct __attribute__((packed)) TelemetryChannel
+{
+  uint8_t Index;
+  uint8_t Count;              // Channels in the layout
+  ChannelInfo Info;
+};
+
+static_assert(sizeof(TelemetryHeader) == 13, "TelemetryHeader layout changed");
+static_assert(sizeof(TelemetryChannel) <= TELEMETRY_MAX_PAYLOAD, "TelemetryChannel does not fit a frame");
+static_assert((TELEMETRY_BUFFER_SIZE & (TELEMETRY_BUFFER_SIZE - 1)) == 0, "Buffer size must be a power of two");
+
+// CRC-32 as in zlib / Ethernet, pass the previous result to continue
+uint32_t TelemetryCrc32(const void* Data, uint32_t Size, uint32_t Crc = 0);
+
+// Out needs Size + Size / 254 + 1 bytes. Returns the encoded length, which contains no zero.
+uint32_t CobsEncode(const uint8_t* In, uint32_t Size, uint8_t* Out);
+
+// Out needs Size bytes. Returns the decoded length, -1 when In is not valid COBS.
+int32_t CobsDecode(const uint8_t* In, uint32_t Size, uint8_t* Out);
+
+class TelemetryStream
+{
+public:
+  // Encodes and queues one frame. False and counted as dropped when the ring is full.
+  bool Send(E_TELEMETRY_TYPE Type, uint64_t Time, const void* Payload, uint32_t Size);
+
+  // Moves whole frames to the console, never more than it can accept right now
+  void Service(void);
+
+  // Frames lost before they reached the stream still use up their sequence numbers
+  void Skip(uint32_t Frames) { Sequence += Frames; }
+
+  uint32_t GetPending(void) const { return Head - Tail; }
+  uint32_t GetSequence(void) const { return Sequence; }
+  uint32_t GetDropped(void) const { return Dropped; }
+
+private:
+  uint32_t FrameLength(uint32_t Start) const;
+
+  uint8_t Buffer[TELEMETRY_BUFFER_SIZE];
+
+  // Free running byte counters, Tail always sits on the start of a frame
+  uint32_t Head = 0;
+  uint32_t Tail = 0;
+  uint32_t Sequence = 0;
+  uint32_t Dropped = 0;
+};
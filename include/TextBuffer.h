@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Fixed-capacity text formatting
+*
+* TextBuffer<Size> keeps its characters inline (stack or static), always NUL
+* terminated. Appends that do not fit are cut at the capacity and flag the buffer
+* as truncated. Floats go through a fixed-point conversion: scale, round to an
+* integer, print the digits. That is several times cheaper than printf("%.nf"),
+* and nothing ever touches the heap.
+*/
+
+#define TEXT_MAX_DECIMALS               6
+
+class TextWriter
+{
+public:
+  TextWriter& Append(const char* Text);
+  TextWriter& Append(char Character);
+  TextWriter& AppendUnsigned(uint32_t Value);
+  TextWriter& AppendInt(int32_t Value);
+
+  // Rounded to Decimals (at most TEXT_MAX_DECIMALS) places; "nan", "inf" or "ovf" when not representable
+  TextWriter& AppendFixed(float Value, uint8_t Decimals);
+
+  void Clear(void);
+
+  const char* c_str(void) const { return Buffer; }
+  uint32_t GetLength(void) const { return Length; }
+  uint32_t GetCapacity(void) const { return Capacity - 1; }
+  bool IsTruncated(void) const { return Truncated; }
+
+protected:
+  TextWriter(char* Buffer, uint32_t Capacity) : Buffer(Buffer), Capacity(Capacity) { Buffer[0] = '\0'; }
+
+private:
+  TextWriter& AppendDigits(uint64_t Value, uint8_t MinDigits);
+
+  char* Buffer;
+  uint32_t Capacity;          // Including the terminator
+  uint32_t Length = 0;
+  bool Truncated = false;
+};
+
+template <uint32_t Size>
+class TextBuffer : public TextWriter
+{
+  static_assert(Size > 1, "Size must leave room for the terminator");
+
+public:
+  TextBuffer() : TextWriter(Storage, Size) {}
+  explicit TextBuffer(const char* Text) : TextWriter(Storage, Size) { Append(Text); }
+
+  // The writer points into this object, so copies would alias the source
+  TextBuffer(const TextBuffer&) = delete;
+  TextBuffer& operator=(const TextBuffer&) = delete;
+
+private:
+  char Storage[Size];
+};
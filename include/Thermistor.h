@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Thermistor lookup table
+*
+* The voltage divider + Steinhart-Hart conversion is evaluated at compile time for
+* every ADC code of a THERMISTOR_TABLE_BITS converter. Higher resolution codes are
+* linearly interpolated between neighbouring entries.
+*/
+
+#define THERMISTOR_TABLE_BITS           10
+#define THERMISTOR_TABLE_SIZE           (1u << THERMISTOR_TABLE_BITS)
+#define THERMISTOR_SUPPLY_VOLTAGE       3.3
+
+struct ThermistorCoefficients
+{
+  double C1, C2, C3;
+};
+
+constexpr ThermistorCoefficients THERMISTOR_DEFAULT_COEFFICIENTS { 1.009249522e-03, 2.378405444e-04, 2.019202697e-07 };
+
+// Natural log usable in constant expressions, x > 0
+constexpr double ConstexprLog(double x)
+{
+  const double Ln2 = 0.693147180559945309417;
+
+  // x = m * 2^k with m in [1, 2)
+  int k = 0;
+  while (x >= 2.0) { x /= 2.0; k++; }
+  while (x < 1.0) { x *= 2.0; k--; }
+
+  // ln(m) = 2 * atanh(z), z = (m - 1) / (m + 1) <= 1/3
+  double z = (x - 1.0) / (x + 1.0);
+  double z2 = z * z;
+  double Term = z;
+  double Sum = 0.0;
+  for (int n = 1; n < 60; n += 2)
+  {
+    Sum += Term / n;
+    Term *= z2;
+  }
+  return 2.0 * Sum + k * Ln2;
+}
+
+class ThermistorTable
+{
+public:
+  constexpr ThermistorTable(double Resistance, double CalibrationOffset,
+                            const ThermistorCoefficients& Coefficients = THERMISTOR_DEFAULT_COEFFICIENTS)
+    : Table{}
+  {
+    for (uint32_t Code = 0; Code < THERMISTOR_TABLE_SIZE; Code++)
+    {
+      Table[Code] = float(Evaluate(Code, Resistance, Coefficients) + CalibrationOffset);
+    }
+  }
+
+  // Reference formula, the same maths ReadThermistor() used to do per sample
+  static constexpr double Evaluate(uint32_t Code, double Resistance, const ThermistorCoefficients& Coefficients)
+  {
+    // An open divider reads 0, which is the 0 K limit of the formula
+    if (Code == 0) return -273.15;
+
+    double Vo = (THERMISTOR_SUPPLY_VOLTAGE / THERMISTOR_TABLE_SIZE) * Code;
+    double R = Resistance * (THERMISTOR_SUPPLY_VOLTAGE - Vo) / Vo;
+    double LogR = ConstexprLog(R);
+    return 1.0 / (Coefficients.C1 + Coefficients.C2 * LogR + Coefficients.C3 * LogR * LogR * LogR) - 273.15;
+  }
+
+  // Code is a raw reading of a Resolution bit ADC
+  float Convert(uint32_t Code, uint8_t Resolution = THERMISTOR_TABLE_BITS) const
+  {
+    if (Resolution <= THERMISTOR_TABLE_BITS) return Table[Code << (THERMISTOR_TABLE_BITS - Resolution)];
+
+    uint8_t Shift = Resolution - THERMISTOR_TABLE_BITS;
+    uint32_t Index = Code >> Shift;
+    if (Index >= THERMISTOR_TABLE_SIZE - 1) return Table[THERMISTOR_TABLE_SIZE - 1];
+
+    float Fraction = float(Code & ((1u << Shift) - 1)) / float(1u << Shift);
+    return Table[Index] + (Table[Index + 1] - Table[Index]) * Fraction;
+  }
+
+  constexpr float operator[](uint32_t Code) const { return Table[Code]; }
+
+private:
+  float Table[THERMISTOR_TABLE_SIZE];
+};
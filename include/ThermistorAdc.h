@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Background analog acquisition
+*
+* One ADC converts continuously with hardware averaging and DMA fills a double
+* buffer. Every completed block belongs to one channel; it is decimated to a single
+* code and the ADC moves on to the next channel, round robin. The thermistors and any
+* other analog channel of the registry (ChannelRegistry.h) share it. loop() only
+* reads GetLatest().
+*
+* The DMA backend lives in ThermistorAdcDma.cpp (Teensy 4.x), the simulated one in
+* ThermistorAdcSim.cpp (host builds). Both feed blocks through OnBlockComplete().
+*/
+
+#define THERMISTOR_ADC_RESOLUTION       12
+#define THERMISTOR_ADC_AVERAGING        16  // Hardware averaged conversions per sample
+#define THERMISTOR_ADC_BLOCK_SIZE       128 // Samples per DMA half buffer
+#define THERMISTOR_ADC_SETTLE_SAMPLES   2   // Dropped after a channel switch
+#define THERMISTOR_ADC_CHANNELS         4   // Most pins one engine cycles through
+
+struct ThermistorAdcReading
+{
+  uint16_t Code;              // THERMISTOR_ADC_RESOLUTION bit
+  uint64_t Time;              // ClockMicros() when the block completed
+};
+
+// Rounded mean of Count samples, shared by all backends
+uint16_t ThermistorAdcDecimate(const volatile uint16_t* Samples, uint32_t Count);
+
+class ThermistorAdc
+{
+public:
+  // Implemented by the backend
+  void Begin(const uint8_t* Pins, uint8_t Count);
+
+  // Safe against a concurrent OnBlockComplete()
+  ThermistorAdcReading GetLatest(uint8_t Channel) const;
+
+  // Backend side, usually ISR context. Returns the channel to convert next.
+  uint8_t OnBlockComplete(const volatile uint16_t* Samples, uint32_t Count, uint64_t Time);
+
+  uint8_t GetActiveChannel(void) const { return Active; }
+  uint8_t GetPin(uint8_t Channel) const { return Pins[Channel]; }
+  uint8_t GetChannelCount(void) const { return ChannelCount; }
+  uint32_t GetBlockCount(uint8_t Channel) const { return Sequence[Channel] / 2; }
+
+private:
+  void Reset(const uint8_t* Pins, uint8_t Count);
+
+  volatile uint16_t Code[THERMISTOR_ADC_CHANNELS] = {};
+  volatile uint64_t Time[THERMISTOR_ADC_CHANNELS] = {};
+  volatile uint32_t Sequence[THERMISTOR_ADC_CHANNELS] = {};   // Odd while a channel is being written
+  uint8_t Pins[THERMISTOR_ADC_CHANNELS] = {};
+  uint8_t ChannelCount = 1;
+  volatile uint8_t Active = 0;
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "ThermistorAdc.h"
+
+/* Simulated ThermistorAdc backend for host builds
+*
+* Stands in for the ADC + DMA hardware: each call produces one block for the active
+* channel from raw conversions returned by Source, then hands it to the engine.
+*/
+
+// Returns one raw THERMISTOR_ADC_RESOLUTION bit conversion of Pin
+typedef uint16_t (*ThermistorAdcSource)(void* Context, uint8_t Pin);
+
+// Engine the last Begin() was called on, nullptr before that
+ThermistorAdc* ThermistorAdcSimInstance(void);
+
+void ThermistorAdcSimulateBlock(ThermistorAdc& Adc, ThermistorAdcSource Source, void* Context, uint64_t Time);
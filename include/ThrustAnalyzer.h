@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Streaming thrust curve analysis
+*
+* Update() folds one force sample into the results with O(1) memory. Impulse is
+* integrated with the trapezoidal rule on the real sample timestamps, over every
+* interval that starts while the motor is burning. The burn starts when force first
+* reaches the onset threshold and ends when it falls below the burnout threshold;
+* a motor that comes back above the onset threshold resumes the burn.
+*/
+
+struct ThrustResults
+{
+  float TotalImpulse;         // Ns
+  float PeakThrust;           // N
+  float AverageThrust;        // N, TotalImpulse / BurnTime
+  float BurnTime;             // s
+  uint64_t OnsetTime;         // us
+  uint64_t BurnoutTime;       // us
+  uint64_t PeakTime;          // us
+  bool Ignited;
+  bool BurnedOut;
+};
+
+class ThrustAnalyzer
+{
+public:
+  ThrustAnalyzer(float OnsetThreshold, float BurnoutThreshold)
+    : OnsetThreshold(OnsetThreshold), BurnoutThreshold(BurnoutThreshold) {}
+
+  void Reset(void);
+  void Update(uint64_t Time, float Force);
+
+  const ThrustResults& GetResults(void) const { return Results; }
+  bool IsBurning(void) const { return Results.Ignited && !Results.BurnedOut; }
+
+  // NAR/CAR class for a total impulse, "1/8A" up to "O", "-" for no impulse
+  static const char* MotorClass(float TotalImpulse);
+
+private:
+  float OnsetThreshold;
+  float BurnoutThreshold;
+
+  ThrustResults Results = {};
+  bool HasPrevious = false;
+  uint64_t PreviousTime = 0;
+  float PreviousForce = 0;
+};
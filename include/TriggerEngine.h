@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Thrust onset trigger
+*
+* Armed with the time of the relay command, fires on the first run of
+* ConfirmSamples consecutive samples at or above Threshold. The raw force is used
+* on purpose: any filtering here would add to the trigger latency.
+*/
+
+class TriggerEngine
+{
+public:
+  TriggerEngine(float Threshold, uint8_t ConfirmSamples) : Threshold(Threshold), ConfirmSamples(ConfirmSamples) {}
+
+  void Arm(uint64_t CommandTime);
+  void Disarm(void) { Armed = false; }
+
+  // Returns true only for the sample that fires the trigger
+  bool Update(uint64_t Time, float Force);
+
+  bool IsArmed(void) const { return Armed; }
+  bool IsTriggered(void) const { return Triggered; }
+  uint64_t GetTriggerTime(void) const { return TriggerTime; }   // First sample of the confirming run
+  uint64_t GetLatency(void) const { return TriggerTime - CommandTime; }
+
+private:
+  float Threshold;
+  uint8_t ConfirmSamples;
+
+  bool Armed = false;
+  bool Triggered = false;
+  uint8_t Above = 0;
+  uint64_t CommandTime = 0;
+  uint64_t TriggerTime = 0;
+};
@@ -0,0 +1,1145 @@
+#include "App.h"
+#include "BoundedQueue.h"
+#include "BurnoutDetector.h"
+#include "CaptureArena.h"
+#include "Channels.h"
+#include "Clock.h"
+#include "Config.h"
+#include "ForceFilter.h"
+#include "Hal.h"
+#include "LogRecorder.h"
+#include "Profiler.h"
+#include "RecorderBenchmark.h"
+#include "RingBuffer.h"
+#include "Scheduler.h"
+#include "SpscQueue.h"
+#include "StateMachine.h"
+#include "Telemetry.h"
+#include "TextBuffer.h"
+#include "ThermistorAdc.h"
+#include "ThrustAnalyzer.h"
+#include "TriggerEngine.h"
+
+
+enum E_OPERATION_TRIGGER : uint8_t {
+  TRIGGER_SETUP_DONE = 0,     // End of AppSetup()
+  TRIGGER_START_COMMAND,      // APP_EVENT_START_COMMAND
+  TRIGGER_TICK                // Every run of the State task
+};
+
+// Scheduler task ids, AppSetup() adds them in this order
+enum E_APP_TASK : int8_t {
+  APP_TASK_LOAD_CELL = 0,
+  APP_TASK_ANALOG,
+  APP_TASK_LOG,
+  APP_TASK_STATE,
+  APP_TASK_DISPLAY,
+  APP_TASK_TELEMETRY
+};
+
+enum E_APP_EVENT : uint8_t {
+  APP_EVENT_START_COMMAND = 0,  // Test start button
+  APP_EVENT_COUNT
+};
+
+const char* const S_APP_EVENT[]{
+  "StartCommand"
+};
+
+// Posted from interrupt context, handled by DispatchEvents() in the main context
+struct AppEvent
+{
+  uint64_t Time;              // ClockMicros() in the ISR
+  E_APP_EVENT Type;
+};
+
+struct AppEventStats
+{
+  uint32_t Posted;
+  uint32_t Ignored;           // Not valid in the state at dispatch, e.g. switch bounce
+  uint32_t LastLatency;       // us from the ISR to the end of its handler
+  uint32_t MaxLatency;
+};
+
+/* Function Definitions */
+
+// Initializers
+void InitSerial(void);
+void InitRecorder(void);
+void InitLoadCell(void);
+void BeginForceFilter(uint32_t SampleRate);
+void InitAnalog(void);
+void InitDisplay(void);
+void InitGPIO(void);
+
+// Operational functions
+void GetAnalogData(void);
+void GetLoadCellData(void);
+LoadCellSample ReadLoadCells(uint64_t Time);
+LogRecord CreateLogRecord(const LoadCellSample& Sample);
+void LogTestData(const LogRecord& Record);
+
+// Specific commands
+void LoadCellTare(void);
+void InterruptTestStartCommand(void);
+void InterruptLoadCellDataReady(void);
+bool DispatchEvents(void);
+void DisplayRenderData(void);
+void DisplayService(void);
+bool CreateLogFile(void);
+void CloseLogFile(void);
+void WriteCaptureArena(void);
+void UpdateOperationState(void);
+
+// State actions and guards
+void EnterError(void);
+void StartCountdown(void);
+void UpdateCountdown(void);
+void BeginTest(void);
+void UpdateTestDuration(void);
+void EndTest(void);
+void EnterPostTest(void);
+void ReportStartFailure(void);
+bool SetupFailed(void);
+bool LogFileMissing(void);
+bool CountdownElapsed(void);
+bool BurnoutSeen(void);
+bool DurationElapsed(void);
+void ReportSchedulerStats(HalPrint& Out);
+void ReportPipelineStats(HalPrint& Out);
+void ReportEventStats(HalPrint& Out);
+void ReportStateStats(HalPrint& Out);
+void WriteTestSummary(void);
+void ReportThrustResults(HalPrint& Out);
+void ToggleRelay(bool Status);
+void EnterBurstMode(void);
+void ExitBurstMode(void);
+bool ShouldLogSample(uint64_t Time);
+void CreateTelemetryString(void);
+void SendChannelLayout(void);
+void AppendError(const char* Message);
+void StreamTelemetry(const LogRecord& Record);
+void TelemetryService(void);
+void LogService(void);
+void NoteConsumerAge(E_LOG_CONSUMER Consumer, uint64_t Time);
+LogFileTrailer CreateLogTrailer(void);
+void FormatLogFileName(TextWriter& Name, const char* Suffix);
+
+/* Other Definitions */
+
+// Countdown 
+uint64_t CountdownActivatedTime = 10^10;
+uint64_t TestActivatedTime = 10^10;
+float Countdown = TEST_COUNTDOWN_SECONDS;
+float TestDuration = TEST_DURATION_SECONDS;
+
+// Sensor data, Channels.h lists every channel
+SensorChannels Channels;
+ThermistorAdc AnalogAdc;
+SpscQueue<LoadCellSample, 64> LoadCellQueue;
+ForceFilter Filter;           // Designed for the rate the HX711s convert at right now
+float FilterTestDelay;        // Samples at FORCE_FILTER_SAMPLE_RATE, what the log and summary report
+uint32_t FilterTestDelayTime; // us
+constexpr uint8_t LOAD_CELL_DATA_PINS[] = { GPIO_LOAD_CELL_DT, GPIO_LOAD_CELL_DT_2, GPIO_LOAD_CELL_DT_3, GPIO_LOAD_CELL_DT_4 };
+
+static_assert(LOAD_CELL_COUNT >= 1 && LOAD_CELL_COUNT <= HAL_LOAD_CELLS, "One to HAL_LOAD_CELLS load cells share the clock");
+RingBuffer<LogRecord, PRETRIGGER_SECONDS * PRETRIGGER_SAMPLE_RATE> PretriggerHistory;
+
+// Records one log can hold: the whole pre-trigger history goes out at the start command,
+// then the countdown at the test rate. Burst mode may keep every conversion for the
+// whole test window.
+constexpr uint32_t LOG_FILE_RECORDS = PRETRIGGER_SECONDS * PRETRIGGER_SAMPLE_RATE
+  + TEST_COUNTDOWN_SECONDS * TEST_DATA_SAMPLE_RATE + TEST_DURATION_SECONDS * LOAD_CELL_MAX_RATE;
+
+// Events. Single producer: InterruptTestStartCommand() is the only caller of Push().
+// Another ISR must not post here too (it could preempt a Push() halfway), it needs its
+// own queue or a post with interrupts off.
+SpscQueue<AppEvent, EVENT_QUEUE_DEPTH> EventQueue;
+AppEventStats EventStats[APP_EVENT_COUNT];
+
+// Pipeline, GetLoadCellData() hands every sample to each consumer's own queue
+BoundedQueue<LogRecord, PIPELINE_LOG_DEPTH> LogQueue(PIPELINE_LOG_POLICY);
+BoundedQueue<LogRecord, PIPELINE_TELEMETRY_DEPTH> TelemetryQueue(PIPELINE_TELEMETRY_POLICY);
+BoundedQueue<LogRecord, PIPELINE_DISPLAY_DEPTH> DisplayQueue(PIPELINE_DISPLAY_POLICY);
+uint32_t ConsumerMaxAge[LOG_CONSUMER_COUNT];
+uint32_t TelemetryQueueLost;  // Queue drops already skipped in the telemetry sequence
+
+// Recorder 
+HalFile File;
+uint32_t LogFileNumber;
+TextBuffer<32> LogFileName;
+LogRecorder Recorder;
+bool LogStarted = false;
+bool LogActive = false;       // COUNTDOWN and TEST_ACTIVE, set by the state actions
+uint64_t NextLogTime;
+CaptureArena Capture;
+bool Capturing = false;
+
+// Analysis
+bool AnalysisActive = false;  // TEST_ACTIVE, set by the state actions
+ThrustAnalyzer Analyzer(ANALYSIS_ONSET_THRESHOLD, ANALYSIS_BURNOUT_THRESHOLD);
+ThrustAnalyzer FilteredAnalyzer(ANALYSIS_ONSET_THRESHOLD, ANALYSIS_BURNOUT_THRESHOLD);
+
+BurnoutDetector Burnout(uint32_t(BURNOUT_FILTER_TIME_CONSTANT * 1e6f), BURNOUT_ONSET_THRESHOLD, BURNOUT_THRESHOLD,
+  uint32_t(BURNOUT_HOLDOFF_SECONDS * 1e6f));
+
+// Trigger
+TriggerEngine Trigger(TRIGGER_THRESHOLD, TRIGGER_CONFIRM_SAMPLES);
+bool BurstMode = false;
+
+// Telemetry
+TelemetryStream Telemetry;
+uint64_t NextLayoutTime;
+
+static_assert(SensorChannels::DATA_SIZE + 1 <= TELEMETRY_MAX_PAYLOAD, "Channels do not fit a telemetry sample");
+
+// Display
+LogRecord DisplayRecord;
+uint8_t DisplayTileRow;
+uint64_t DisplayRenderPrev;
+
+// Debug
+TextBuffer<128> ErrorLog;   // Fixed size, messages past the end are cut
+bool SetupError = false;    // An initializer failed, setup ends in ERROR
+
+// Tasks
+Scheduler Tasks(ClockMicros);
+
+// Operation state, sensors run in every state so the display stays live. The log task
+// drains LogQueue wherever samples are produced; outside COUNTDOWN and TEST_ACTIVE it
+// only keeps the pre-trigger history.
+constexpr uint32_t SENSOR_TASKS = StateTask(APP_TASK_LOAD_CELL) | StateTask(APP_TASK_ANALOG) | StateTask(APP_TASK_LOG);
+constexpr uint32_t OUTPUT_TASKS = StateTask(APP_TASK_DISPLAY) | StateTask(APP_TASK_TELEMETRY);
+
+constexpr StateDefinition<E_OPERATION_STATE> OPERATION_STATES[] = {
+  // State              Name                   Entry           Exit     Update              Tasks
+  { STARTUP,             "STARTUP",             nullptr,        nullptr, nullptr,            0 },
+  { ERROR,               "ERROR",               EnterError,     nullptr, nullptr,            SENSOR_TASKS | OUTPUT_TASKS },
+  { READY_FOR_COUNTDOWN, "READY_FOR_COUNTDOWN", nullptr,        nullptr, nullptr,            SENSOR_TASKS | OUTPUT_TASKS },
+  { COUNTDOWN,           "COUNTDOWN",           StartCountdown, nullptr, UpdateCountdown,    ~0u },
+  { TEST_ACTIVE,         "TEST_ACTIVE",         BeginTest,      EndTest, UpdateTestDuration, ~0u },
+  { POST_TEST,           "POST_TEST",           EnterPostTest,  nullptr, nullptr,            SENSOR_TASKS | OUTPUT_TASKS }
+};
+
+constexpr StateTransition<E_OPERATION_STATE, E_OPERATION_TRIGGER> OPERATION_TRANSITIONS[] = {
+  // From               Trigger                Guard             Action              To
+  { STARTUP,             TRIGGER_SETUP_DONE,    SetupFailed,      nullptr,            ERROR },
+  { STARTUP,             TRIGGER_SETUP_DONE,    nullptr,          nullptr,            READY_FOR_COUNTDOWN },
+  { READY_FOR_COUNTDOWN, TRIGGER_START_COMMAND, LogFileMissing,   ReportStartFailure, ERROR },
+  { READY_FOR_COUNTDOWN, TRIGGER_START_COMMAND, nullptr,          nullptr,            COUNTDOWN },
+  { COUNTDOWN,           TRIGGER_TICK,          CountdownElapsed, nullptr,            TEST_ACTIVE },
+  { TEST_ACTIVE,         TRIGGER_TICK,          BurnoutSeen,      nullptr,            POST_TEST },
+  { TEST_ACTIVE,         TRIGGER_TICK,          DurationElapsed,  nullptr,            POST_TEST }
+};
+
+static_assert(StateTableValid(OPERATION_STATES), "OPERATION_STATES rows must follow E_OPERATION_STATE");
+static_assert(TransitionTableValid(OPERATION_TRANSITIONS, OPERATION_STATE_COUNT), "Bad row in OPERATION_TRANSITIONS");
+
+StateMachine<E_OPERATION_STATE, E_OPERATION_TRIGGER, OPERATION_STATE_COUNT, sizeof(OPERATION_TRANSITIONS) / sizeof(OPERATION_TRANSITIONS[0])>
+  Operation(OPERATION_STATES, OPERATION_TRANSITIONS, Tasks, ClockMicros);
+
+
+void InitSerial(void)
+{
+  // The baud rate is ignored by the native USB serial, which runs at full USB speed
+  HalConsoleBegin(115200);
+}
+
+void InitRecorder(void)
+{
+  if (!HalFsBegin())
+  {
+    SetupError = true;
+    AppendError("SD-CARD NOT FOUND | ");
+    return;
+  }
+
+#if RECORDER_BENCHMARK
+  RecorderBenchmark(LogFileSize(LOG_FILE_RECORDS), HalConsole());
+#endif
+
+#if RECORDER_CAPTURE_PSRAM
+  // Attached up front so nothing is allocated once the test sequence runs
+  Capture.Begin();
+#endif
+
+  // Created before the countdown so no FAT work happens once the test is armed
+  if (!CreateLogFile())
+  {
+    SetupError = true;
+    AppendError("LOG FILE NOT CREATED | ");
+  }
+}
+
+void BeginForceFilter(uint32_t SampleRate)
+{
+  Filter.Begin(FORCE_FILTER ? FORCE_FILTER_TYPE : FORCE_FILTER_NONE, SampleRate, FORCE_FILTER_CUTOFF, FORCE_FILTER_LENGTH);
+}
+
+void InitLoadCell(void)
+{
+  // The test runs at the full rate, that delay goes into the log and the summary
+  BeginForceFilter(FORCE_FILTER_SAMPLE_RATE);
+  FilterTestDelay = Filter.GetDelay();
+  FilterTestDelayTime = Filter.GetDelayTime();
+#if GPIO_LOAD_CELL_RATE != 255
+  BeginForceFilter(LOAD_CELL_SLOW_RATE);
+#endif
+
+  if (!HalLoadCellBegin(LOAD_CELL_DATA_PINS, LOAD_CELL_COUNT, LOAD_CELL_SETTLE_TIME, LOAD_CELL_CALIBRATION_VALUE))
+  {
+    SetupError = true;
+    AppendError("LOAD CELL TARE UNSUCESSFUL | ");
+  }
+
+#if LOAD_CELL_ACQUISITION_INTERRUPT
+  // The last DOUT to fall finds every cell ready and reads them all
+  for (uint8_t i = 0; i < LOAD_CELL_COUNT; i++)
+  {
+    HalAttachInterrupt(LOAD_CELL_DATA_PINS[i], InterruptLoadCellDataReady, HAL_INTERRUPT_FALLING);
+  }
+#endif
+}
+
+void InitAnalog(void)
+{
+  for (uint8_t i = 0; i < SensorChannels::ADC_PINS.Count; i++) HalPinMode(SensorChannels::ADC_PINS.Pin[i], HAL_INPUT);
+  Channels.Begin(AnalogAdc);
+}
+
+void InitDisplay(void)
+{
+  HalDisplayBegin(DISPLAY_BUS_CLOCK);
+}
+
+void InitGPIO(void)
+{
+  HalPinMode(GPIO_RELAY_TOGGLE, HAL_OUTPUT);
+  HalPinMode(GPIO_LED_TEST_ACTIVE, HAL_OUTPUT);
+  HalPinMode(GPIO_BUTTON_ACTIVATE_TEST, HAL_INPUT);
+#if GPIO_LOAD_CELL_RATE != 255
+  HalPinMode(GPIO_LOAD_CELL_RATE, HAL_OUTPUT);
+  HalDigitalWrite(GPIO_LOAD_CELL_RATE, false);
+#endif
+  // Edge, a level interrupt would keep firing for as long as the button is held
+  HalAttachInterrupt(GPIO_BUTTON_ACTIVATE_TEST, InterruptTestStartCommand, HAL_INTERRUPT_RISING);
+}
+
+void InterruptTestStartCommand(void)
+{
+  // Only timestamps the press, the state machine does the work in the main context
+  EventQueue.Push({ ClockMicros(), APP_EVENT_START_COMMAND });
+}
+
+bool DispatchEvents(void)
+{
+  AppEvent Event;
+  if (!EventQueue.Pop(Event)) return false;
+
+  AppEventStats& Stats = EventStats[Event.Type];
+  Stats.Posted++;
+
+  bool Handled = false;
+  switch (Event.Type)
+  {
+  case APP_EVENT_START_COMMAND:
+    Handled = Operation.Dispatch(TRIGGER_START_COMMAND, Event.Time);
+    break;
+
+  default:
+    break;
+  }
+
+  if (!Handled)
+  {
+    Stats.Ignored++;
+    return true;
+  }
+
+  uint64_t Latency = ClockMicros() - Event.Time;
+  Stats.LastLatency = uint32_t(Latency > UINT32_MAX ? UINT32_MAX : Latency);
+  if (Stats.LastLatency > Stats.MaxLatency) Stats.MaxLatency = Stats.LastLatency;
+  return true;
+}
+
+void InterruptLoadCellDataReady(void)
+{
+  PROFILE_SCOPE(PROFILE_LOAD_CELL_ISR);
+
+  // DOUT falls when a conversion is ready, so this is the sample time
+  uint64_t Time = ClockMicros();
+  if (HalLoadCellUpdate())
+  {
+    LoadCellQueue.Push(ReadLoadCells(Time));
+  }
+}
+
+LoadCellSample ReadLoadCells(uint64_t Time)
+{
+  LoadCellSample Sample;
+  Sample.Time = Time;
+  Sample.Force = 0.0f;
+  for (uint8_t i = 0; i < LOAD_CELL_COUNT; i++)
+  {
+    Sample.Cells[i] = HalLoadCellGetData(i) / 100000.f;
+    Sample.Force += Sample.Cells[i];
+  }
+  Sample.Filtered = Sample.Force;   // GetLoadCellData() runs the filter
+  return Sample;
+}
+
+void CreateTelemetryString(void)
+{
+  LogFileHeader Header{};
+  Header.Magic = LOG_FILE_MAGIC;
+  Header.Version = LOG_FILE_VERSION;
+  Header.RecordSize = sizeof(LogRecord);
+  Header.SampleRate = TEST_DATA_SAMPLE_RATE;   // The history and burst mode log every conversion
+  Header.TrailerSize = sizeof(LogFileTrailer);
+  Header.ChannelCount = SensorChannels::COUNT;
+  Header.FilterType = Filter.GetType();
+  Header.FilterDelay = FilterTestDelayTime;
+
+#if RECORDER_CAPTURE_PSRAM
+  Capture.Clear();
+  Capturing = Capture.IsAvailable() && Capture.Append(&Header, sizeof(Header))
+    && Capture.Append(SensorChannels::INFO, sizeof(SensorChannels::INFO));
+  if (!Capturing) AppendError("NO PSRAM, LOGGING TO SD | ");
+#endif
+
+  if (!Capturing)
+  {
+    Recorder.Begin(&File);
+    Recorder.Push(&Header, sizeof(Header));
+    Recorder.Push(SensorChannels::INFO, sizeof(SensorChannels::INFO));
+  }
+
+  // Everything seen before the start command, oldest first
+  LogRecord Record;
+  while (PretriggerHistory.Pop(Record)) LogTestData(Record);
+
+  LogStarted = true;
+}
+
+void DisplayService(void)
+{
+  // Only the latest sample is shown
+  while (DisplayQueue.Pop(DisplayRecord))
+  {
+    NoteConsumerAge(LOG_CONSUMER_DISPLAY, DisplayRecord.Time);
+  }
+
+  // Send the last frame one tile row (128 bytes) per call so I2C never blocks a tick for long
+  if (DisplayTileRow < HalDisplayGetTileRows())
+  {
+    PROFILE_SCOPE(PROFILE_DISPLAY_SEND);
+    HalDisplaySendTileRow(DisplayTileRow);
+    DisplayTileRow++;
+    return;
+  }
+
+  if (ClockMillis() - DisplayRenderPrev < 1000 / DISPLAY_REFRESH_RATE) return;
+  DisplayRenderPrev = ClockMillis();
+  DisplayRenderData();
+}
+
+void DisplayRenderData(void)
+{
+  PROFILE_SCOPE(PROFILE_DISPLAY_RENDER);
+  HalDisplayClear();
+
+  /* Layout
+  * STATE
+  * ERROR CODE
+  * TELEMETRY
+  */ 
+
+  HalDisplayDrawHLine(5, 0, 120);
+  HalDisplayDrawHLine(5, 10, 120);
+
+  HalDisplaySetFont(HAL_FONT_SMALL);
+  HalDisplayDrawStr(5, 8, Operation.GetName(Operation.GetState()));
+  HalDisplayDrawStr(5, 19, ErrorLog.c_str());
+
+  // Labelled channels, three rows per page, pages take turns when there are more
+  uint8_t Labelled = 0;
+  for (uint8_t i = 0; i < SensorChannels::COUNT; i++) Labelled += SensorChannels::LABELS[i] != nullptr;
+  uint8_t Pages = (Labelled + 2) / 3;
+  uint8_t Page = Pages > 1 ? uint8_t(ClockMillis() / (DISPLAY_PAGE_SECONDS * 1000) % Pages) : 0;
+
+  TextBuffer<16> Value;
+  uint8_t Row = 0;
+  for (uint8_t i = 0; i < SensorChannels::COUNT; i++)
+  {
+    if (SensorChannels::LABELS[i] == nullptr) continue;
+    if (Row++ / 3 != Page) continue;
+
+    uint8_t y = 42 + 10 * ((Row - 1) % 3);
+    TextBuffer<20> Label;
+    Label.Append(SensorChannels::LABELS[i]);
+    while (Label.GetLength() < 14) Label.Append(' ');
+    HalDisplayDrawStr(5, y, Label.Append('=').c_str());
+
+    Value.Clear();
+    HalDisplayDrawStr(70, y, Value.AppendFixed(SensorChannels::GetFloat(DisplayRecord, i), 2).c_str());
+  }
+
+  if (Operation.GetState() == E_OPERATION_STATE::POST_TEST)
+  {
+    const ThrustResults& Results = Analyzer.GetResults();
+    TextBuffer<48> Line;
+    Line.Append("I=").AppendFixed(Results.TotalImpulse, 1)
+      .Append("Ns PEAK=").AppendFixed(Results.PeakThrust, 1)
+      .Append("N BURN=").AppendFixed(Results.BurnTime, 2).Append('s');
+    HalDisplayDrawStr(5, 30, Line.c_str());
+
+    HalDisplaySetFont(HAL_FONT_LARGE);
+    HalDisplayDrawStr(96, 56, ThrustAnalyzer::MotorClass(Results.TotalImpulse));
+  }
+  else
+  {
+    HalDisplaySetFont(HAL_FONT_LARGE);
+    Value.Clear();
+    HalDisplayDrawStr(96, 56, Value.AppendInt(int32_t(TEST_COUNTDOWN_SECONDS - Countdown)).c_str());
+  }
+
+  // Frame is only in RAM, DisplayService() sends it
+  DisplayTileRow = 0;
+}
+
+void LoadCellTare(void)
+{
+  HalLoadCellTare();
+}
+
+void CloseLogFile(void)
+{
+  // Accounting up to the end of the test, not including the write-out below
+  LogFileTrailer Trailer = CreateLogTrailer();
+
+  Recorder.Flush();
+  uint32_t End = Recorder.GetFileOffset() > Capture.GetUsed() ? Recorder.GetFileOffset() : Capture.GetUsed();
+
+  WriteCaptureArena();
+  if (LogStarted)
+  {
+    File.SeekSet(End);
+    File.Write(&Trailer, sizeof(Trailer));
+    File.Sync();
+    End += sizeof(Trailer);
+  }
+  File.Truncate(End);
+  File.Close();
+}
+
+LogFileTrailer CreateLogTrailer(void)
+{
+  LogFileTrailer Trailer{};
+  Trailer.Magic = LOG_TRAILER_MAGIC;
+  Trailer.AcquisitionDropped = LoadCellQueue.GetDropped();
+  Trailer.RecorderDropped = Recorder.GetDropped();
+  Trailer.TelemetryDropped = Telemetry.GetDropped();
+
+  const QueueStats* Stats[LOG_CONSUMER_COUNT] = { &LogQueue.GetStats(), &TelemetryQueue.GetStats(), &DisplayQueue.GetStats() };
+  const E_QUEUE_POLICY Policies[LOG_CONSUMER_COUNT] = { LogQueue.GetPolicy(), TelemetryQueue.GetPolicy(), DisplayQueue.GetPolicy() };
+  for (uint8_t i = 0; i < LOG_CONSUMER_COUNT; i++)
+  {
+    LogConsumerStats& Consumer = Trailer.Consumers[i];
+    Consumer.Pushed = Stats[i]->Pushed;
+    Consumer.Dropped = Stats[i]->Dropped;
+    Consumer.Decimated = Stats[i]->Decimated;
+    Consumer.HighWater = Stats[i]->HighWater;
+    Consumer.MaxAge = ConsumerMaxAge[i];
+    Consumer.Policy = Policies[i];
+  }
+  return Trailer;
+}
+
+void WriteCaptureArena(void)
+{
+  if (Capture.GetUsed() == 0) return;
+
+  // Bulk write after the burn, the arena always starts at the beginning of the file
+  File.SeekSet(0);
+  for (uint32_t Offset = 0; Offset < Capture.GetUsed(); Offset += CAPTURE_WRITE_CHUNK)
+  {
+    uint32_t Size = Capture.GetUsed() - Offset;
+    if (Size > CAPTURE_WRITE_CHUNK) Size = CAPTURE_WRITE_CHUNK;
+    File.Write(Capture.GetData() + Offset, Size);
+  }
+  File.Sync();
+
+  Capture.Clear();
+  Capturing = false;
+}
+
+void EnterError(void)
+{
+  HalConsole().Printf("ERROR %s\n", ErrorLog.c_str());
+}
+
+void ReportStartFailure(void)
+{
+  AppendError("STARTUP NOT SUCESSFUL | ");
+}
+
+void StartCountdown(void)
+{
+  HalDigitalWrite(GPIO_LED_TEST_ACTIVE, true);
+  // Entered at the press, not when it was dispatched
+  CountdownActivatedTime = Operation.GetEnteredTime() / 1000;
+  LogActive = true;
+}
+
+void UpdateCountdown(void)
+{
+  Countdown = float(ClockMillis() - CountdownActivatedTime) / 1000.f;
+}
+
+void BeginTest(void)
+{
+  TestActivatedTime = ClockMillis();
+  Recorder.Flush();
+  Analyzer.Reset();
+  FilteredAnalyzer.Reset();
+  Burnout.Reset();
+
+  uint64_t RelayCommandTime = ClockMicros();
+  ToggleRelay(true);
+  Trigger.Arm(RelayCommandTime);
+  AnalysisActive = true;
+}
+
+void UpdateTestDuration(void)
+{
+  TestDuration = float(ClockMillis() - TestActivatedTime) / 1000.f;
+
+  // For displaying test duration
+  Countdown = TestDuration + 15;
+}
+
+void EndTest(void)
+{
+  // Consumers catch up on the test before the log write-out blocks the loop
+  AnalysisActive = false;
+  LogService();
+  TelemetryService();
+  LogActive = false;
+
+  HalDigitalWrite(GPIO_LED_TEST_ACTIVE, false);
+  Trigger.Disarm();
+  ExitBurstMode();
+}
+
+void EnterPostTest(void)
+{
+  CloseLogFile();
+  ToggleRelay(false);
+  WriteTestSummary();
+}
+
+bool SetupFailed(void)
+{
+  return SetupError;
+}
+
+bool LogFileMissing(void)
+{
+  return !File.IsOpen();
+}
+
+bool CountdownElapsed(void)
+{
+  return Countdown >= TEST_COUNTDOWN_SECONDS;
+}
+
+bool BurnoutSeen(void)
+{
+  return BURNOUT_DETECTION && Burnout.IsBurnedOut();
+}
+
+bool DurationElapsed(void)
+{
+  return TestDuration >= TEST_DURATION_SECONDS;
+}
+
+void EnterBurstMode(void)
+{
+  BurstMode = true;
+#if GPIO_LOAD_CELL_RATE != 255
+  HalDigitalWrite(GPIO_LOAD_CELL_RATE, true);
+  BeginForceFilter(LOAD_CELL_MAX_RATE);
+#endif
+  Tasks.SetPeriod(APP_TASK_LOAD_CELL, 1000000 / TASK_LOAD_CELL_BURST_RATE);
+  Tasks.SetPeriod(APP_TASK_ANALOG, 1000000 / TASK_ANALOG_BURST_RATE);
+}
+
+void ExitBurstMode(void)
+{
+  BurstMode = false;
+#if GPIO_LOAD_CELL_RATE != 255
+  HalDigitalWrite(GPIO_LOAD_CELL_RATE, false);
+  BeginForceFilter(LOAD_CELL_SLOW_RATE);
+#endif
+  Tasks.SetPeriod(APP_TASK_LOAD_CELL, 1000000 / TASK_LOAD_CELL_RATE);
+  Tasks.SetPeriod(APP_TASK_ANALOG, 1000000 / SensorChannels::POLL_RATE);
+}
+
+bool ShouldLogSample(uint64_t Time)
+{
+  // Burst mode keeps every conversion, otherwise records go out at TEST_DATA_SAMPLE_RATE
+  if (BurstMode) return true;
+  if (Time < NextLogTime) return false;
+
+  NextLogTime += 1000000 / TEST_DATA_SAMPLE_RATE;
+  if (NextLogTime < Time) NextLogTime = Time + 1000000 / TEST_DATA_SAMPLE_RATE;
+  return true;
+}
+
+static void WriteReportLine(const char* Line, void* Context)
+{
+  ((HalPrint*) Context)->Print(Line);
+}
+
+void WriteTestSummary(void)
+{
+  ReportThrustResults(HalConsole());
+  ReportSchedulerStats(HalConsole());
+  ReportPipelineStats(HalConsole());
+  ReportEventStats(HalConsole());
+  ReportStateStats(HalConsole());
+  ProfilerReport(WriteReportLine, &HalConsole());
+
+  TextBuffer<48> SummaryName;
+  FormatLogFileName(SummaryName, " Summary.txt");
+
+  HalFile Summary;
+  if (!Summary.Open(SummaryName.c_str()))
+  {
+    AppendError("SUMMARY NOT WRITTEN | ");
+    return;
+  }
+
+  ReportThrustResults(Summary);
+  ReportSchedulerStats(Summary);
+  ReportPipelineStats(Summary);
+  ReportEventStats(Summary);
+  ReportStateStats(Summary);
+  ProfilerReport(WriteReportLine, &Summary);
+  Summary.Close();
+}
+
+// Microseconds as seconds with all six decimals, exact where a float would not be
+static TextWriter& AppendSeconds(TextWriter& Line, uint64_t Time)
+{
+  uint32_t Micros = uint32_t(Time % 1000000);
+  Line.AppendUnsigned(uint32_t(Time / 1000000)).Append('.');
+  for (uint32_t Digit = 100000; Digit > 1 && Micros < Digit; Digit /= 10) Line.Append('0');
+  return Line.AppendUnsigned(Micros);
+}
+
+// Written after the test, so no printf float conversions: newlib's allocate
+void ReportThrustResults(HalPrint& Out)
+{
+  const ThrustResults& Results = Analyzer.GetResults();
+  TextBuffer<96> Line;
+
+  if (Burnout.IsBurnedOut())
+  {
+    Line.Append("Test ended by burnout detection after ").AppendFixed(TestDuration, 2).Append(" s");
+    Out.Println(Line.c_str());
+  }
+  else
+  {
+    Out.Printf("Test ended at the %d s limit\n", TEST_DURATION_SECONDS);
+  }
+
+  if (Trigger.IsTriggered())
+  {
+    Line.Clear();
+    Line.Append("Thrust trigger  = ").AppendFixed(Trigger.GetLatency() / 1000.0f, 3).Append(" ms after relay command");
+    Out.Println(Line.c_str());
+  }
+  else
+  {
+    Out.Println("Thrust trigger  = not fired");
+  }
+
+  if (!Results.Ignited)
+  {
+    Out.Println("NO IGNITION DETECTED");
+    return;
+  }
+
+  Out.Printf("Motor class     = %s\n", ThrustAnalyzer::MotorClass(Results.TotalImpulse));
+  Line.Clear();
+  Line.Append("Total impulse   = ").AppendFixed(Results.TotalImpulse, 3).Append(" Ns");
+  Out.Println(Line.c_str());
+  Line.Clear();
+  Line.Append("Peak thrust     = ").AppendFixed(Results.PeakThrust, 2).Append(" N at ");
+  Out.Println(AppendSeconds(Line, Results.PeakTime).Append(" s").c_str());
+#if FORCE_FILTER
+  // The filtered peak shows up one group delay late, report it where it happened
+  const ThrustResults& Filtered = FilteredAnalyzer.GetResults();
+  Line.Clear();
+  Line.Append("Force filter    = ").Append(ForceFilter::TypeName(Filter.GetType()))
+    .Append(", group delay ").AppendFixed(FilterTestDelay, 2)
+    .Append(" samples (").AppendFixed(FilterTestDelayTime / 1000.0f, 1).Append(" ms)");
+  Out.Println(Line.c_str());
+  if (Filtered.Ignited)
+  {
+    Line.Clear();
+    Line.Append("Filtered peak   = ").AppendFixed(Filtered.PeakThrust, 2).Append(" N at ");
+    Out.Println(AppendSeconds(Line, Filtered.PeakTime - FilterTestDelayTime).Append(" s").c_str());
+  }
+#endif
+  Line.Clear();
+  Line.Append("Average thrust  = ").AppendFixed(Results.AverageThrust, 2).Append(" N");
+  Out.Println(Line.c_str());
+  Line.Clear();
+  Line.Append("Burn time       = ").AppendFixed(Results.BurnTime, 3).Append(" s (");
+  AppendSeconds(Line, Results.OnsetTime).Append(" s to ");
+  AppendSeconds(Line, Results.BurnoutTime).Append(" s)");
+  Out.Println(Line.Append(Results.BurnedOut ? "" : ", no burnout detected").c_str());
+}
+
+void ReportSchedulerStats(HalPrint& Out)
+{
+  for (uint8_t i = 0; i < Tasks.GetTaskCount(); i++)
+  {
+    const SchedulerTask& Task = Tasks.GetTask(i);
+    Out.Printf("TASK %-10s runs %lu, deadline misses %lu, skipped %lu, max lateness %lu us\n",
+      Task.Name,
+      (unsigned long) Task.Runs,
+      (unsigned long) Task.DeadlineMisses,
+      (unsigned long) Task.SkippedReleases,
+      (unsigned long) Task.MaxLateness);
+  }
+}
+
+void ReportPipelineStats(HalPrint& Out)
+{
+  const char* const Names[LOG_CONSUMER_COUNT] = { "Log", "Telemetry", "Display" };
+  const QueueStats* Stats[LOG_CONSUMER_COUNT] = { &LogQueue.GetStats(), &TelemetryQueue.GetStats(), &DisplayQueue.GetStats() };
+
+  Out.Printf("QUEUE %-10s dropped %lu\n", "LoadCell", (unsigned long) LoadCellQueue.GetDropped());
+  for (uint8_t i = 0; i < LOG_CONSUMER_COUNT; i++)
+  {
+    Out.Printf("QUEUE %-10s pushed %lu, dropped %lu, decimated %lu, high water %lu, max age %lu us\n",
+      Names[i],
+      (unsigned long) Stats[i]->Pushed,
+      (unsigned long) Stats[i]->Dropped,
+      (unsigned long) Stats[i]->Decimated,
+      (unsigned long) Stats[i]->HighWater,
+      (unsigned long) ConsumerMaxAge[i]);
+  }
+}
+
+void ReportEventStats(HalPrint& Out)
+{
+  Out.Printf("EVENT %-12s dropped %lu\n", "Queue", (unsigned long) EventQueue.GetDropped());
+  for (uint8_t i = 0; i < APP_EVENT_COUNT; i++)
+  {
+    const AppEventStats& Stats = EventStats[i];
+    Out.Printf("EVENT %-12s posted %lu, ignored %lu, latency %lu us, max latency %lu us\n",
+      S_APP_EVENT[i],
+      (unsigned long) Stats.Posted,
+      (unsigned long) Stats.Ignored,
+      (unsigned long) Stats.LastLatency,
+      (unsigned long) Stats.MaxLatency);
+  }
+}
+
+void ReportStateStats(HalPrint& Out)
+{
+  for (uint8_t i = 0; i < OPERATION_STATE_COUNT; i++)
+  {
+    E_OPERATION_STATE State = E_OPERATION_STATE(i);
+    TextBuffer<24> Time;
+    Time.AppendFixed(Operation.GetTime(State) * 1e-6f, 3);
+    Out.Printf("STATE %-19s entries %lu, time %s s\n",
+      Operation.GetName(State),
+      (unsigned long) Operation.GetEntries(State),
+      Time.c_str());
+  }
+
+  for (uint8_t i = 0; i < Operation.GetTransitionCount(); i++)
+  {
+    const auto& Row = Operation.GetTransition(i);
+    Out.Printf("TRANSITION %u %-19s -> %-19s taken %lu\n",
+      unsigned(i),
+      Operation.GetName(Row.From),
+      Operation.GetName(Row.To),
+      (unsigned long) Operation.GetTaken(i));
+  }
+}
+
+LogRecord CreateLogRecord(const LoadCellSample& Sample)
+{
+  // Analog values were converted by their own task, this only copies them
+  LogRecord Record;
+  Channels.Fill(Record, Sample);
+  return Record;
+}
+
+void LogTestData(const LogRecord& Record)
+{
+  PROFILE_SCOPE(PROFILE_LOG_TEST_DATA);
+
+  if (Capturing)
+  {
+    if (Capture.Append(&Record, sizeof(Record))) return;
+
+    // Arena is full, the rest streams to SD right behind where the arena contents will go
+    Capturing = false;
+    File.SeekSet(Capture.GetUsed());
+    Recorder.Begin(&File, Capture.GetUsed());
+  }
+
+  Recorder.Push(Record);
+  Recorder.Drain();
+}
+
+bool CreateLogFile(void)
+{
+  do
+  {
+    LogFileNumber = HalRandom(100);
+    LogFileName.Clear();
+    FormatLogFileName(LogFileName, ".bin");
+  } while (HalFsExists(LogFileName.c_str()));
+  
+  if (!File.Open(LogFileName.c_str())) return false;
+
+#if RECORDER_PREALLOCATE
+  if (!File.PreAllocate(LogFileSize(LOG_FILE_RECORDS)))
+  {
+    // Still usable, the file just grows cluster by cluster during the test
+    AppendError("LOG NOT PREALLOCATED | ");
+  }
+#endif
+  return true;
+}
+
+void ToggleRelay(bool Status)
+{
+  if (Status == false)
+  {
+    HalDigitalWrite(GPIO_RELAY_TOGGLE, true);
+    return;
+  }
+  HalDigitalWrite(GPIO_RELAY_TOGGLE, false);
+}
+
+void GetAnalogData(void)
+{
+  PROFILE_SCOPE(PROFILE_ANALOG);
+
+  // Latest decimated blocks from the background ADC, no conversion happens here
+  Channels.Poll(AnalogAdc);
+}
+
+void GetLoadCellData(void)
+{
+  PROFILE_SCOPE(PROFILE_LOAD_CELL);
+
+#if !LOAD_CELL_ACQUISITION_INTERRUPT
+  if (HalLoadCellUpdate())
+  {
+    LoadCellQueue.Push(ReadLoadCells(ClockMicros()));
+  }
+#endif
+
+  // Pending conversions go through the filter as one block. Trigger and analysis run
+  // here, everything else is a consumer with its own queue.
+  LoadCellSample Samples[FORCE_FILTER_BLOCK_SIZE];
+  float Forces[FORCE_FILTER_BLOCK_SIZE];
+  uint32_t Count;
+  do
+  {
+    Count = 0;
+    while (Count < FORCE_FILTER_BLOCK_SIZE && LoadCellQueue.Pop(Samples[Count]))
+    {
+      Forces[Count] = Samples[Count].Force;
+      Count++;
+    }
+
+    {
+      PROFILE_SCOPE(PROFILE_FORCE_FILTER);
+      Filter.Process(Forces, Forces, Count);
+    }
+
+    for (uint32_t i = 0; i < Count; i++)
+    {
+      LoadCellSample& Sample = Samples[i];
+      Sample.Filtered = Forces[i];
+
+      if (AnalysisActive)
+      {
+        if (Trigger.Update(Sample.Time, Sample.Force)) EnterBurstMode();
+        Analyzer.Update(Sample.Time, Sample.Force);
+        FilteredAnalyzer.Update(Sample.Time, Sample.Filtered);
+        Burnout.Update(Sample.Time, Sample.Force);
+      }
+
+      LogRecord Record = CreateLogRecord(Sample);
+      LogQueue.Push(Record);
+#if TELEMETRY_STREAM
+      TelemetryQueue.Push(Record);
+#endif
+      DisplayQueue.Push(Record);
+    }
+  } while (Count == FORCE_FILTER_BLOCK_SIZE);
+}
+
+void LogService(void)
+{
+  // Conversions are logged at the test rate, or all of them in burst mode
+  LogRecord Record;
+  while (LogQueue.Pop(Record))
+  {
+    NoteConsumerAge(LOG_CONSUMER_LOG, Record.Time);
+    if (LogActive)
+    {
+      // Header and pre-trigger history go out before the first live record
+      if (!LogStarted) CreateTelemetryString();
+      if (ShouldLogSample(Record.Time)) LogTestData(Record);
+    }
+
+    PretriggerHistory.Push(Record);
+  }
+}
+
+void NoteConsumerAge(E_LOG_CONSUMER Consumer, uint64_t Time)
+{
+  uint64_t Age = ClockMicros() - Time;
+  if (Age > UINT32_MAX) Age = UINT32_MAX;
+  if (Age > ConsumerMaxAge[Consumer]) ConsumerMaxAge[Consumer] = uint32_t(Age);
+}
+
+void StreamTelemetry(const LogRecord& Record)
+{
+#if TELEMETRY_STREAM
+  uint8_t Payload[SensorChannels::DATA_SIZE + 1];
+  memcpy(Payload, Record.Data, SensorChannels::DATA_SIZE);
+  Payload[SensorChannels::DATA_SIZE] = Operation.GetState();
+
+  // Dropped when the host falls behind, the sequence number tells it so
+  Telemetry.Send(TELEMETRY_SAMPLE, Record.Time, Payload, sizeof(Payload));
+#else
+  (void) Record;
+#endif
+}
+
+void SendChannelLayout(void)
+{
+  for (uint8_t i = 0; i < SensorChannels::COUNT; i++)
+  {
+    TelemetryChannel Channel = { i, SensorChannels::COUNT, SensorChannels::INFO[i] };
+    Telemetry.Send(TELEMETRY_CHANNEL, ClockMicros(), &Channel, sizeof(Channel));
+  }
+}
+
+void TelemetryService(void)
+{
+  // Hosts that attach late learn the record layout within a period
+  if (ClockMillis() >= NextLayoutTime)
+  {
+    NextLayoutTime = ClockMillis() + TELEMETRY_LAYOUT_PERIOD;
+    SendChannelLayout();
+  }
+
+  // Samples the queue dropped were older than the ones still in it
+  uint32_t Lost = TelemetryQueue.GetStats().Dropped + TelemetryQueue.GetStats().Decimated;
+  Telemetry.Skip(Lost - TelemetryQueueLost);
+  TelemetryQueueLost = Lost;
+
+  LogRecord Record;
+  while (TelemetryQueue.Pop(Record))
+  {
+    NoteConsumerAge(LOG_CONSUMER_TELEMETRY, Record.Time);
+    StreamTelemetry(Record);
+  }
+  Telemetry.Service();
+}
+
+void AppendError(const char* Message)
+{
+  // Keeps the start of the log when it overflows
+  ErrorLog.Append(Message);
+}
+
+void FormatLogFileName(TextWriter& Name, const char* Suffix)
+{
+  Name.Append("Motor Test Data #").AppendUnsigned(LogFileNumber).Append(Suffix);
+}
+
+void AppSetup(void) 
+{
+  // Initializers
+  ClockBegin();
+  Operation.Begin(E_OPERATION_STATE::STARTUP);
+  InitSerial();
+  InitGPIO();
+  InitRecorder();
+  InitLoadCell();
+  InitAnalog();
+  InitDisplay();
+  
+  // Tasks in E_APP_TASK order, the state machine enables each state's set
+  Tasks.Add("LoadCell", GetLoadCellData, 1000000 / TASK_LOAD_CELL_RATE, 3);
+  Tasks.Add("Analog", GetAnalogData, 1000000 / SensorChannels::POLL_RATE, 2);
+  Tasks.Add("Log", LogService, 1000000 / TASK_LOG_RATE, 2);
+  Tasks.Add("State", UpdateOperationState, 1000000 / TASK_STATE_RATE, 2);
+  Tasks.Add("Display", DisplayService, 1000000 / TASK_DISPLAY_RATE, 0);
+#if TELEMETRY_STREAM
+  Tasks.Add("Telemetry", TelemetryService, 1000000 / TASK_TELEMETRY_RATE, 1);
+#endif
+
+  Operation.Dispatch(TRIGGER_SETUP_DONE);
+}
+
+void UpdateOperationState(void)
+{
+  PROFILE_SCOPE(PROFILE_STATE);
+
+  Operation.Update();
+  Operation.Dispatch(TRIGGER_TICK);
+}
+
+bool AppLoop(void)
+{
+  // Events go ahead of every task, so they wait for at most the task that is running
+  if (DispatchEvents()) return true;
+  return Tasks.RunOnce();
+}
+
+uint64_t AppNextWakeup(void)
+{
+  return Tasks.GetNextRelease();
+}
+
+E_OPERATION_STATE AppGetState(void)
+{
+  return Operation.GetState();
+}
+
+uint32_t AppGetStateEntries(E_OPERATION_STATE State)
+{
+  return Operation.GetEntries(State);
+}
+
+uint64_t AppGetStateTime(E_OPERATION_STATE State)
+{
+  return Operation.GetTime(State);
+}
+
+uint32_t AppGetStartLatency(void)
+{
+  return EventStats[APP_EVENT_START_COMMAND].LastLatency;
+}
+
+const Scheduler& AppGetTasks(void)
+{
+  return Tasks;
+}
@@ -0,0 +1,51 @@
+#include "BurnoutDetector.h"
+
+void BurnoutDetector::Reset(void)
+{
+  Filtered = 0;
+  PreviousTime = 0;
+  HasPrevious = false;
+  Ignited = false;
+  BurnedOut = false;
+  Below = false;
+  BurnoutTime = 0;
+}
+
+bool BurnoutDetector::Update(uint64_t Time, float Force)
+{
+  if (!HasPrevious)
+  {
+    Filtered = Force;
+  }
+  else
+  {
+    // alpha = dt / (tau + dt), close to 1 - exp(-dt / tau) without the exp
+    float Interval = float(Time - PreviousTime);
+    Filtered += (Force - Filtered) * (Interval / (float(TimeConstant) + Interval));
+  }
+  HasPrevious = true;
+  PreviousTime = Time;
+
+  if (BurnedOut) return true;
+
+  if (!Ignited)
+  {
+    Ignited = Filtered >= OnsetThreshold;
+    return false;
+  }
+
+  if (Filtered >= BurnoutThreshold)
+  {
+    Below = false;
+    return false;
+  }
+
+  if (!Below)
+  {
+    Below = true;
+    BurnoutTime = Time;
+  }
+
+  BurnedOut = Time - BurnoutTime >= Holdoff;
+  return BurnedOut;
+}
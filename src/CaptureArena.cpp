@@ -0,0 +1,47 @@
+#include "CaptureArena.h"
+
+#include <string.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+
+extern "C" uint8_t external_psram_size;   // MB, set by the Teensy startup code
+
+EXTMEM static uint8_t ArenaStorage[CAPTURE_ARENA_SIZE];
+
+static uint8_t* CaptureArenaAllocate(void)
+{
+  // EXTMEM is only backed when a PSRAM chip is soldered on
+  if (uint32_t(external_psram_size) * 1024ul * 1024ul < CAPTURE_ARENA_SIZE) return nullptr;
+  return ArenaStorage;
+}
+#else
+#include <stdlib.h>
+
+#include "HalSim.h"
+
+static uint8_t* CaptureArenaAllocate(void)
+{
+  if (!HalSimHasPsram()) return nullptr;
+
+  static uint8_t* Heap = (uint8_t*) malloc(CAPTURE_ARENA_SIZE);
+  return Heap;
+}
+#endif
+
+bool CaptureArena::Begin(void)
+{
+  Storage = CaptureArenaAllocate();
+  Size = Storage ? CAPTURE_ARENA_SIZE : 0;
+  Used = 0;
+  return Storage != nullptr;
+}
+
+bool CaptureArena::Append(const void* Data, uint32_t Length)
+{
+  if (Size - Used < Length) return false;
+
+  memcpy(Storage + Used, Data, Length);
+  Used += Length;
+  return true;
+}
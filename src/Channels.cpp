@@ -0,0 +1,21 @@
+#include "Channels.h"
+#include "Thermistor.h"
+
+constexpr ThermistorTable Thermistor1Table(THERMISTOR_1_RESISTANCE, THERMISTOR_CALIBRATION_OFFSET);
+constexpr ThermistorTable Thermistor2Table(THERMISTOR_2_RESISTANCE, THERMISTOR_CALIBRATION_OFFSET);
+
+float Thermistor1Channel::Convert(uint16_t Code)
+{
+  return Thermistor1Table.Convert(Code, THERMISTOR_ADC_RESOLUTION);
+}
+
+float Thermistor2Channel::Convert(uint16_t Code)
+{
+  return Thermistor2Table.Convert(Code, THERMISTOR_ADC_RESOLUTION);
+}
+
+float ChamberPressureChannel::Convert(uint16_t Code)
+{
+  float Voltage = float(Code) * float(THERMISTOR_SUPPLY_VOLTAGE) / float(1u << THERMISTOR_ADC_RESOLUTION);
+  return (Voltage - PRESSURE_1_ZERO_VOLTAGE) * PRESSURE_1_SCALE;
+}
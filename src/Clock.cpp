@@ -0,0 +1,45 @@
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+
+#include "Clock.h"
+
+static uint32_t LastCycles;
+static uint32_t Wraps;
+static IntervalTimer WrapTimer;
+
+static void ClockKeepAlive(void)
+{
+  ClockCycles();
+}
+
+void ClockBegin(void)
+{
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+
+  LastCycles = ARM_DWT_CYCCNT;
+  WrapTimer.begin(ClockKeepAlive, 1000000);
+}
+
+uint64_t ClockCycles(void)
+{
+  uint32_t Primask;
+  __asm__ volatile("mrs %0, primask" : "=r" (Primask));
+  __disable_irq();
+
+  uint32_t Now = ARM_DWT_CYCCNT;
+  if (Now < LastCycles) Wraps++;
+  LastCycles = Now;
+  uint64_t Cycles = (uint64_t(Wraps) << 32) | Now;
+
+  if (!Primask) __enable_irq();
+  return Cycles;
+}
+
+uint64_t ClockMicros(void)
+{
+  return ClockCycles() / (F_CPU_ACTUAL / 1000000);
+}
+
+#endif
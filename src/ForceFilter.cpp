@@ -0,0 +1,155 @@
+#include "ForceFilter.h"
+
+#include <math.h>
+
+void ForceFilter::Begin(E_FORCE_FILTER Type, float SampleRate, float Cutoff, uint8_t Length)
+{
+  this->Type = Type;
+  this->SampleRate = SampleRate;
+  this->Length = 1;
+  Delay = 0.0f;
+
+  // At a slow conversion rate the cutoff may be past Nyquist, keep it below
+  if (Cutoff > FORCE_FILTER_MAX_CUTOFF * SampleRate) Cutoff = FORCE_FILTER_MAX_CUTOFF * SampleRate;
+
+  switch (Type)
+  {
+  case FORCE_FILTER_BIQUAD:
+  {
+    // RBJ cookbook low pass, normalised to a0 = 1
+    double w = 2.0 * M_PI * Cutoff / SampleRate;
+    double Alpha = sin(w) / (2.0 * M_SQRT1_2);
+    double a0 = 1.0 + Alpha;
+    double b0 = (1.0 - cos(w)) / 2.0 / a0;
+    double b1 = (1.0 - cos(w)) / a0;
+    double a1 = -2.0 * cos(w) / a0;
+    double a2 = (1.0 - Alpha) / a0;
+
+    Coefficients[0] = float(b0);
+    Coefficients[1] = float(b1);
+    Coefficients[2] = float(b0);
+    Coefficients[3] = float(-a1);
+    Coefficients[4] = float(-a2);
+
+    // At DC: sum(k * b[k]) / sum(b[k]) - sum(k * a[k]) / sum(a[k])
+    Delay = float((b1 + 2.0 * b0) / (2.0 * b0 + b1) - (a1 + 2.0 * a2) / (1.0 + a1 + a2));
+    break;
+  }
+
+  case FORCE_FILTER_FIR:
+  {
+    this->Length = Length < 1 ? 1 : (Length > FORCE_FILTER_MAX_TAPS ? FORCE_FILTER_MAX_TAPS : Length) | 1;
+    double Middle = (this->Length - 1) / 2.0;
+    double Fraction = 2.0 * Cutoff / SampleRate;
+    double Sum = 0.0;
+    double Taps[FORCE_FILTER_MAX_TAPS];
+    for (uint8_t i = 0; i < this->Length; i++)
+    {
+      double x = i - Middle;
+      double Sinc = x == 0.0 ? Fraction : sin(M_PI * Fraction * x) / (M_PI * x);
+      double Window = this->Length > 1 ? 0.54 - 0.46 * cos(2.0 * M_PI * i / (this->Length - 1)) : 1.0;
+      Taps[i] = Sinc * Window;
+      Sum += Taps[i];
+    }
+
+    // Unity gain at DC, reversed like CMSIS-DSP stores them
+    for (uint8_t i = 0; i < this->Length; i++) Coefficients[i] = float(Taps[this->Length - 1 - i] / Sum);
+    Delay = float(Middle);
+    break;
+  }
+
+  case FORCE_FILTER_MEDIAN:
+    this->Length = Length < 1 ? 1 : (Length > FORCE_FILTER_MAX_MEDIAN ? FORCE_FILTER_MAX_MEDIAN : Length) | 1;
+    Delay = (this->Length - 1) / 2.0f;
+    break;
+
+  default:
+    this->Type = FORCE_FILTER_NONE;
+    break;
+  }
+
+  Reset();
+}
+
+void ForceFilter::Reset(void)
+{
+  Primed = false;
+}
+
+void ForceFilter::Process(const float* In, float* Out, uint32_t Count)
+{
+  if (Count == 0) return;
+  if (Count > FORCE_FILTER_BLOCK_SIZE) Count = FORCE_FILTER_BLOCK_SIZE;
+
+  // A NaN or inf would stay in the biquad state for good and breaks the median's
+  // ordering, the last finite value stands in for it
+  float Finite[FORCE_FILTER_BLOCK_SIZE];
+  for (uint32_t i = 0; i < Count; i++)
+  {
+    if (isfinite(In[i])) LastFinite = In[i];
+    Finite[i] = LastFinite;
+  }
+  In = Finite;
+
+  // Start as if the first value had always been there, no step from zero
+  if (!Primed)
+  {
+    for (float& Value : State) Value = In[0];
+    for (uint8_t i = 0; i < FORCE_FILTER_MAX_MEDIAN; i++) History[i] = Sorted[i] = In[0];
+    Oldest = 0;
+    Primed = true;
+  }
+
+  switch (Type)
+  {
+  case FORCE_FILTER_BIQUAD:
+    ProcessBiquad(In, Out, Count);
+    break;
+
+  case FORCE_FILTER_FIR:
+    ProcessFir(In, Out, Count);
+    break;
+
+  case FORCE_FILTER_MEDIAN:
+    ProcessMedian(In, Out, Count);
+    break;
+
+  default:
+    for (uint32_t i = 0; i < Count; i++) Out[i] = In[i];
+    break;
+  }
+}
+
+void ForceFilter::ProcessMedian(const float* In, float* Out, uint32_t Count)
+{
+  for (uint32_t i = 0; i < Count; i++)
+  {
+    // Swap the oldest value for the new one and move it to its sorted place
+    float Removed = History[Oldest];
+    float Added = In[i];
+    History[Oldest] = Added;
+    Oldest = Oldest + 1 == Length ? 0 : Oldest + 1;
+
+    uint8_t Slot = 0;
+    while (Slot + 1 < Length && Sorted[Slot] != Removed) Slot++;
+    while (Slot > 0 && Sorted[Slot - 1] > Added)
+    {
+      Sorted[Slot] = Sorted[Slot - 1];
+      Slot--;
+    }
+    while (Slot + 1 < Length && Sorted[Slot + 1] < Added)
+    {
+      Sorted[Slot] = Sorted[Slot + 1];
+      Slot++;
+    }
+    Sorted[Slot] = Added;
+
+    Out[i] = Sorted[Length / 2];
+  }
+}
+
+const char* ForceFilter::TypeName(E_FORCE_FILTER Type)
+{
+  static const char* const NAMES[] = { "none", "biquad", "FIR", "median" };
+  return Type <= FORCE_FILTER_MEDIAN ? NAMES[Type] : "?";
+}
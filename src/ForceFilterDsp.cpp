@@ -0,0 +1,22 @@
+#if defined(__IMXRT1062__)
+
+#include <arm_math.h>
+
+#include "ForceFilter.h"
+
+// The instances only point into the filter, so they are built per call and no
+// CMSIS-DSP type leaks into the header. Both kernels are unrolled for the M7 FPU.
+
+void ForceFilter::ProcessBiquad(const float* In, float* Out, uint32_t Count)
+{
+  arm_biquad_casd_df1_inst_f32 Biquad = { 1, State, Coefficients };
+  arm_biquad_cascade_df1_f32(&Biquad, (float32_t*) In, Out, Count);
+}
+
+void ForceFilter::ProcessFir(const float* In, float* Out, uint32_t Count)
+{
+  arm_fir_instance_f32 Fir = { Length, State, Coefficients };
+  arm_fir_f32(&Fir, (float32_t*) In, Out, Count);
+}
+
+#endif
@@ -0,0 +1,45 @@
+#if !defined(__IMXRT1062__)
+
+#include "ForceFilter.h"
+
+// Same arithmetic as arm_biquad_cascade_df1_f32() with one stage
+void ForceFilter::ProcessBiquad(const float* In, float* Out, uint32_t Count)
+{
+  const float b0 = Coefficients[0], b1 = Coefficients[1], b2 = Coefficients[2];
+  const float a1 = Coefficients[3], a2 = Coefficients[4];
+  float x1 = State[0], x2 = State[1], y1 = State[2], y2 = State[3];
+
+  for (uint32_t i = 0; i < Count; i++)
+  {
+    float x0 = In[i];
+    float y0 = b0 * x0 + b1 * x1 + b2 * x2 + a1 * y1 + a2 * y2;
+    x2 = x1;
+    x1 = x0;
+    y2 = y1;
+    y1 = y0;
+    Out[i] = y0;
+  }
+
+  State[0] = x1;
+  State[1] = x2;
+  State[2] = y1;
+  State[3] = y2;
+}
+
+// Same buffer handling as arm_fir_f32(): history first, the block appended behind it
+void ForceFilter::ProcessFir(const float* In, float* Out, uint32_t Count)
+{
+  float* Line = State + Length - 1;
+  for (uint32_t i = 0; i < Count; i++) Line[i] = In[i];
+
+  for (uint32_t i = 0; i < Count; i++)
+  {
+    float Sum = 0.0f;
+    for (uint8_t k = 0; k < Length; k++) Sum += State[i + k] * Coefficients[k];
+    Out[i] = Sum;
+  }
+
+  for (uint8_t k = 0; k + 1 < Length; k++) State[k] = State[Count + k];
+}
+
+#endif
@@ -0,0 +1,52 @@
+#include "Hx711Array.h"
+
+#include <string.h>
+
+static_assert(HX711_DATA_BITS % 8 == 0 && HX711_CELLS <= 8, "Decode() gathers whole bytes of pulses");
+
+void Hx711Array::Begin(uint8_t Count, float CalibrationFactor)
+{
+  this->Count = Count < 1 ? 1 : (Count > HX711_CELLS ? HX711_CELLS : Count);
+  this->CalibrationFactor = CalibrationFactor;
+  ReadyMask = Hx711Levels((1u << this->Count) - 1);
+  TareLeft = 0;
+  for (uint8_t c = 0; c < HX711_CELLS; c++)
+  {
+    Codes[c] = 0;
+    Offsets[c] = 0;
+  }
+}
+
+void Hx711Array::Decode(const Hx711Levels* Levels)
+{
+  // Eight pulses per word (little endian, first pulse in the low byte). Masking bit c of
+  // every byte and multiplying gathers them into the top byte, first pulse as the MSB.
+  uint64_t Words[HX711_DATA_BITS / 8];
+  memcpy(Words, Levels, sizeof(Words));
+
+  for (uint8_t c = 0; c < Count; c++)
+  {
+    uint32_t Raw = 0;
+    for (uint8_t w = 0; w < HX711_DATA_BITS / 8; w++)
+    {
+      uint64_t Bits = (Words[w] >> c) & 0x0101010101010101ull;
+      Raw = (Raw << 8) | uint32_t((Bits * 0x8040201008040201ull) >> 56);
+    }
+
+    // Two's complement, 24 bit
+    Codes[c] = int32_t(Raw ^ 0x800000) - 0x800000;
+  }
+
+  if (TareLeft == 0) return;
+  for (uint8_t c = 0; c < Count; c++) TareSums[c] += Codes[c];
+  if (--TareLeft == 0)
+  {
+    for (uint8_t c = 0; c < Count; c++) Offsets[c] = int32_t(TareSums[c] / HX711_TARE_SAMPLES);
+  }
+}
+
+void Hx711Array::Tare(void)
+{
+  for (uint8_t c = 0; c < HX711_CELLS; c++) TareSums[c] = 0;
+  TareLeft = HX711_TARE_SAMPLES;
+}
@@ -0,0 +1,61 @@
+#include "LogRecorder.h"
+#include "Profiler.h"
+
+#include <string.h>
+
+void LogRecorder::Begin(HalFile* File, uint32_t BaseOffset)
+{
+  Target = File;
+  Head = BaseOffset;
+  Tail = BaseOffset;
+  Dropped = 0;
+}
+
+bool LogRecorder::Push(const void* Data, uint32_t Size)
+{
+  if (RECORDER_BUFFER_SIZE - GetPending() < Size)
+  {
+    Dropped++;
+    return false;
+  }
+
+  uint32_t Index = Head % RECORDER_BUFFER_SIZE;
+  uint32_t First = Size < RECORDER_BUFFER_SIZE - Index ? Size : RECORDER_BUFFER_SIZE - Index;
+  memcpy(&Buffer[Index], Data, First);
+  memcpy(&Buffer[0], (const uint8_t*) Data + First, Size - First);
+
+  Head += Size;
+  return true;
+}
+
+void LogRecorder::Drain(void)
+{
+  if (Target == nullptr) return;
+  PROFILE_SCOPE(PROFILE_RECORDER_DRAIN);
+
+  // Chunks end on block boundaries so the card only ever sees whole sector writes,
+  // and because the ring holds whole blocks a chunk never wraps.
+  while (true)
+  {
+    uint32_t Chunk = RECORDER_BLOCK_SIZE - (Tail % RECORDER_BLOCK_SIZE);
+    if (GetPending() < Chunk) return;
+    WriteChunk(Chunk);
+  }
+}
+
+void LogRecorder::Flush(void)
+{
+  if (Target == nullptr) return;
+
+  Drain();
+  if (GetPending() != 0) WriteChunk(GetPending());
+
+  PROFILE_SCOPE(PROFILE_RECORDER_SYNC);
+  Target->Sync();
+}
+
+void LogRecorder::WriteChunk(uint32_t Size)
+{
+  Target->Write(&Buffer[Tail % RECORDER_BUFFER_SIZE], Size);
+  Tail += Size;
+}
@@ -0,0 +1,101 @@
+#include "Profiler.h"
+#include "TextBuffer.h"
+
+static ProfileStats Stats[PROFILE_SECTION_COUNT];
+
+static const char* const SectionNames[PROFILE_SECTION_COUNT] = {
+  "LoadCellIsr",
+  "LoadCell",
+  "ForceFilter",
+  "Analog",
+  "LogTestData",
+  "RecorderDrain",
+  "RecorderSync",
+  "DisplayRender",
+  "DisplaySend",
+  "State",
+  "Telemetry"
+};
+
+void ProfilerRecord(E_PROFILE_SECTION Section, uint32_t Ticks)
+{
+  ProfileStats& Entry = Stats[Section];
+
+  if (Entry.Count == 0 || Ticks < Entry.Min) Entry.Min = Ticks;
+  if (Ticks > Entry.Max) Entry.Max = Ticks;
+  Entry.Count++;
+  Entry.Total += Ticks;
+
+  uint8_t Bucket = Ticks == 0 ? 0 : uint8_t(31 - __builtin_clz(Ticks));
+  Entry.Histogram[Bucket]++;
+}
+
+void ProfilerReset(void)
+{
+  for (uint8_t i = 0; i < PROFILE_SECTION_COUNT; i++) Stats[i] = ProfileStats{};
+}
+
+const ProfileStats& ProfilerGetStats(E_PROFILE_SECTION Section)
+{
+  return Stats[Section];
+}
+
+const char* ProfilerGetName(E_PROFILE_SECTION Section)
+{
+  return SectionNames[Section];
+}
+
+// Right aligned in Width columns, like printf("%*s")
+static void AppendColumn(TextWriter& Line, const TextWriter& Field, uint32_t Width)
+{
+  for (uint32_t i = Field.GetLength(); i < Width; i++) Line.Append(' ');
+  Line.Append(Field.c_str());
+}
+
+// Runs after the test while the summary is written, so it formats without printf and
+// its floating point conversions, which allocate in newlib
+void ProfilerReport(ProfilerWriter Write, void* Context)
+{
+  TextBuffer<160> Line;
+  TextBuffer<16> Field;
+  float TicksPerUs = float(ProfilerTicksPerMicrosecond());
+
+  Write("SECTION          COUNT      MIN us     MEAN us      MAX us\n", Context);
+
+  for (uint8_t i = 0; i < PROFILE_SECTION_COUNT; i++)
+  {
+    const ProfileStats& Entry = Stats[i];
+    if (Entry.Count == 0) continue;
+
+    Line.Clear();
+    Line.Append(SectionNames[i]);
+    while (Line.GetLength() < 14) Line.Append(' ');
+    Field.Clear();
+    AppendColumn(Line, Field.AppendUnsigned(Entry.Count), 8);
+    Field.Clear();
+    AppendColumn(Line, Field.AppendFixed(Entry.Min / TicksPerUs, 2), 12);
+    Field.Clear();
+    AppendColumn(Line, Field.AppendFixed(float(Entry.Total) / Entry.Count / TicksPerUs, 2), 12);
+    Field.Clear();
+    AppendColumn(Line, Field.AppendFixed(Entry.Max / TicksPerUs, 2), 12);
+    Write(Line.Append('\n').c_str(), Context);
+
+    // Histogram, one "lower bound:count" pair per used bucket
+    Line.Clear();
+    Line.Append("  histogram (us)");
+    for (uint8_t Bucket = 0; Bucket < PROFILER_BUCKETS; Bucket++)
+    {
+      if (Entry.Histogram[Bucket] == 0) continue;
+
+      if (Line.GetLength() > Line.GetCapacity() - 24)
+      {
+        Write(Line.Append('\n').c_str(), Context);
+        Line.Clear();
+        Line.Append("               ");
+      }
+      float Bound = float(1ul << Bucket) / TicksPerUs;
+      Line.Append(' ').AppendFixed(Bound, Bound < 10.0f ? 3 : 1).Append(':').AppendUnsigned(Entry.Histogram[Bucket]);
+    }
+    Write(Line.Append('\n').c_str(), Context);
+  }
+}
@@ -0,0 +1,62 @@
+#include "RecorderBenchmark.h"
+#include "Clock.h"
+#include "LogRecorder.h"
+
+#include <string.h>
+
+#define RECORDER_BENCHMARK_FILE         "Recorder Benchmark.bin"
+
+static void RunPass(uint32_t Size, bool Preallocate, HalPrint& Out)
+{
+  static uint8_t Block[RECORDER_BLOCK_SIZE] __attribute__((aligned(4)));
+  memset(Block, 0xA5, sizeof(Block));
+
+  HalFile Scratch;
+  HalFsRemove(RECORDER_BENCHMARK_FILE);
+  if (!Scratch.Open(RECORDER_BENCHMARK_FILE))
+  {
+    Out.Println("RECORDER BENCHMARK: OPEN FAILED");
+    return;
+  }
+
+  if (Preallocate && !Scratch.PreAllocate(Size))
+  {
+    Out.Println("RECORDER BENCHMARK: PREALLOCATION FAILED");
+    Scratch.Close();
+    return;
+  }
+
+  uint32_t Blocks = Size / RECORDER_BLOCK_SIZE;
+  uint32_t Worst = 0;
+  uint64_t Total = 0;
+
+  for (uint32_t i = 0; i < Blocks; i++)
+  {
+    uint64_t Start = ClockMicros();
+    Scratch.Write(Block, sizeof(Block));
+    uint32_t Elapsed = uint32_t(ClockMicros() - Start);
+
+    Total += Elapsed;
+    if (Elapsed > Worst) Worst = Elapsed;
+  }
+
+  uint64_t Start = ClockMicros();
+  Scratch.Truncate(Scratch.GetPosition());
+  Scratch.Close();
+  uint32_t CloseTime = uint32_t(ClockMicros() - Start);
+
+  HalFsRemove(RECORDER_BENCHMARK_FILE);
+
+  Out.Printf("RECORDER BENCHMARK %s: %lu blocks, mean %lu us, worst %lu us, close %lu us\n",
+    Preallocate ? "PREALLOCATED" : "GROWING",
+    (unsigned long) Blocks,
+    (unsigned long) (Blocks ? Total / Blocks : 0),
+    (unsigned long) Worst,
+    (unsigned long) CloseTime);
+}
+
+void RecorderBenchmark(uint32_t Size, HalPrint& Out)
+{
+  RunPass(Size, false, Out);
+  RunPass(Size, true, Out);
+}
@@ -0,0 +1,96 @@
+#include "Scheduler.h"
+
+int8_t Scheduler::Add(const char* Name, SchedulerFunction Function, uint32_t Period, uint8_t Priority)
+{
+  if (TaskCount >= SCHEDULER_MAX_TASKS || Period == 0) return -1;
+
+  SchedulerTask& Task = Tasks[TaskCount];
+  Task = SchedulerTask{};
+  Task.Name = Name;
+  Task.Function = Function;
+  Task.Period = Period;
+  Task.Priority = Priority;
+  Task.Enabled = true;
+  Task.NextRelease = Clock();
+
+  return int8_t(TaskCount++);
+}
+
+void Scheduler::SetPeriod(int8_t Id, uint32_t Period)
+{
+  if (Id < 0 || Id >= TaskCount || Period == 0) return;
+
+  // Keep the current release, the new period applies from the next one on
+  Tasks[Id].Period = Period;
+}
+
+void Scheduler::SetEnabled(int8_t Id, bool Enabled)
+{
+  if (Id < 0 || Id >= TaskCount) return;
+
+  if (Enabled && !Tasks[Id].Enabled) Tasks[Id].NextRelease = Clock();
+  Tasks[Id].Enabled = Enabled;
+}
+
+bool Scheduler::RunOnce(void)
+{
+  uint64_t Now = Clock();
+
+  SchedulerTask* Next = nullptr;
+  for (uint8_t i = 0; i < TaskCount; i++)
+  {
+    SchedulerTask& Task = Tasks[i];
+    if (!Task.Enabled || Task.NextRelease > Now) continue;
+
+    if (Next == nullptr
+      || Task.Priority > Next->Priority
+      || (Task.Priority == Next->Priority && Task.NextRelease < Next->NextRelease))
+    {
+      Next = &Task;
+    }
+  }
+  if (Next == nullptr) return false;
+
+  uint64_t Release = Next->NextRelease;
+  uint64_t Lateness = Now - Release;
+  if (Lateness > Next->MaxLateness) Next->MaxLateness = uint32_t(Lateness > UINT32_MAX ? UINT32_MAX : Lateness);
+
+  Next->Function();
+  Next->Runs++;
+
+  uint64_t Finished = Clock();
+  uint64_t Deadline = Release + Next->Period;
+  if (Finished > Deadline) Next->DeadlineMisses++;
+
+  // Stay on the original phase, dropping releases that already passed. Finishing right
+  // on the next release met the deadline, that release still runs.
+  Next->NextRelease = Deadline;
+  if (Next->NextRelease < Finished)
+  {
+    uint64_t Skipped = (Finished - Next->NextRelease - 1) / Next->Period + 1;
+    Next->SkippedReleases += uint32_t(Skipped);
+    Next->NextRelease += Skipped * Next->Period;
+  }
+  return true;
+}
+
+uint64_t Scheduler::GetNextRelease(void) const
+{
+  uint64_t Next = UINT64_MAX;
+  for (uint8_t i = 0; i < TaskCount; i++)
+  {
+    if (Tasks[i].Enabled && Tasks[i].NextRelease < Next) Next = Tasks[i].NextRelease;
+  }
+  return Next;
+}
+
+void Scheduler::ResetStats(void)
+{
+  for (uint8_t i = 0; i < TaskCount; i++)
+  {
+    Tasks[i].Runs = 0;
+    Tasks[i].DeadlineMisses = 0;
+    Tasks[i].SkippedReleases = 0;
+    Tasks[i].MaxLateness = 0;
+  }
+}
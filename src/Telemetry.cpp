@@ -0,0 +1,142 @@
+#include "Telemetry.h"
+#include "Hal.h"
+#include "Profiler.h"
+
+#include <string.h>
+
+class Crc32Table
+{
+public:
+  constexpr Crc32Table() : Table{}
+  {
+    for (uint32_t i = 0; i < 256; i++)
+    {
+      uint32_t Crc = i;
+      for (uint8_t Bit = 0; Bit < 8; Bit++) Crc = (Crc >> 1) ^ (Crc & 1 ? 0xEDB88320u : 0);
+      Table[i] = Crc;
+    }
+  }
+
+  constexpr uint32_t operator[](uint8_t Index) const { return Table[Index]; }
+
+private:
+  uint32_t Table[256];
+};
+
+static constexpr Crc32Table CRC32_TABLE;
+
+uint32_t TelemetryCrc32(const void* Data, uint32_t Size, uint32_t Crc)
+{
+  const uint8_t* Bytes = (const uint8_t*) Data;
+  Crc = ~Crc;
+  for (uint32_t i = 0; i < Size; i++) Crc = (Crc >> 8) ^ CRC32_TABLE[uint8_t(Crc ^ Bytes[i])];
+  return ~Crc;
+}
+
+uint32_t CobsEncode(const uint8_t* In, uint32_t Size, uint8_t* Out)
+{
+  // Every run of up to 254 non-zero bytes is prefixed with its length + 1
+  uint32_t Code = 0;
+  uint32_t Length = 1;
+  for (uint32_t i = 0; i < Size; i++)
+  {
+    if (In[i] != 0)
+    {
+      Out[Length++] = In[i];
+      if (Length - Code < 0xFF) continue;
+    }
+    Out[Code] = uint8_t(Length - Code);
+    Code = Length++;
+  }
+  Out[Code] = uint8_t(Length - Code);
+  return Length;
+}
+
+int32_t CobsDecode(const uint8_t* In, uint32_t Size, uint8_t* Out)
+{
+  uint32_t Length = 0;
+  uint32_t i = 0;
+  while (i < Size)
+  {
+    uint8_t Code = In[i++];
+    if (Code == 0 || i + Code - 1 > Size) return -1;
+
+    for (uint8_t j = 1; j < Code; j++)
+    {
+      if (In[i] == 0) return -1;
+      Out[Length++] = In[i++];
+    }
+    if (Code != 0xFF && i < Size) Out[Length++] = 0;
+  }
+  return int32_t(Length);
+}
+
+bool TelemetryStream::Send(E_TELEMETRY_TYPE Type, uint64_t Time, const void* Payload, uint32_t Size)
+{
+  if (Size > TELEMETRY_MAX_PAYLOAD) return false;
+
+  TelemetryHeader Header;
+  Header.Type = Type;
+  Header.Sequence = Sequence++;
+  Header.Time = Time;
+
+  uint8_t Raw[TELEMETRY_MAX_RAW];
+  memcpy(Raw, &Header, sizeof(Header));
+  memcpy(Raw + sizeof(Header), Payload, Size);
+  uint32_t RawSize = sizeof(Header) + Size;
+  uint32_t Crc = TelemetryCrc32(Raw, RawSize);
+  memcpy(Raw + RawSize, &Crc, sizeof(Crc));
+  RawSize += sizeof(Crc);
+
+  // The leading delimiter resynchronises the receiver after console text or line noise
+  uint8_t Frame[TELEMETRY_MAX_FRAME];
+  Frame[0] = 0;
+  uint32_t Length = 1 + CobsEncode(Raw, RawSize, Frame + 1);
+  Frame[Length++] = 0;
+
+  if (TELEMETRY_BUFFER_SIZE - GetPending() < Length)
+  {
+    Dropped++;
+    return false;
+  }
+
+  uint32_t Index = Head % TELEMETRY_BUFFER_SIZE;
+  uint32_t First = Length < TELEMETRY_BUFFER_SIZE - Index ? Length : TELEMETRY_BUFFER_SIZE - Index;
+  memcpy(&Buffer[Index], Frame, First);
+  memcpy(&Buffer[0], Frame + First, Length - First);
+
+  Head += Length;
+  return true;
+}
+
+void TelemetryStream::Service(void)
+{
+  PROFILE_SCOPE(PROFILE_TELEMETRY);
+
+  // Whole frames only, so anything else printed to the console falls between two of them
+  uint32_t Available = HalConsoleWriteAvailable();
+  uint32_t Size = 0;
+  while (Size < GetPending())
+  {
+    uint32_t Length = FrameLength(Tail + Size);
+    if (Size + Length > Available) break;
+    Size += Length;
+  }
+
+  while (Size != 0)
+  {
+    uint32_t Index = Tail % TELEMETRY_BUFFER_SIZE;
+    uint32_t Chunk = Size < TELEMETRY_BUFFER_SIZE - Index ? Size : TELEMETRY_BUFFER_SIZE - Index;
+    HalConsole().Write(&Buffer[Index], Chunk);
+    Tail += Chunk;
+    Size -= Chunk;
+  }
+}
+
+uint32_t TelemetryStream::FrameLength(uint32_t Start) const
+{
+  // Runs from the leading delimiter up to and including the next zero
+  uint32_t Length = 1;
+  while (Buffer[(Start + Length) % TELEMETRY_BUFFER_SIZE] != 0) Length++;
+  return Length + 1;
+}
@@ -0,0 +1,81 @@
+#include "TextBuffer.h"
+
+static const uint32_t Pow10[TEXT_MAX_DECIMALS + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+TextWriter& TextWriter::Append(const char* Text)
+{
+  while (*Text != '\0')
+  {
+    if (Length + 1 >= Capacity)
+    {
+      Truncated = true;
+      break;
+    }
+    Buffer[Length++] = *Text++;
+  }
+  Buffer[Length] = '\0';
+  return *this;
+}
+
+TextWriter& TextWriter::Append(char Character)
+{
+  const char Text[2] = { Character, '\0' };
+  return Append(Text);
+}
+
+TextWriter& TextWriter::AppendUnsigned(uint32_t Value)
+{
+  return AppendDigits(Value, 1);
+}
+
+TextWriter& TextWriter::AppendInt(int32_t Value)
+{
+  if (Value < 0)
+  {
+    Append('-');
+    return AppendDigits(uint64_t(-int64_t(Value)), 1);
+  }
+  return AppendDigits(uint64_t(Value), 1);
+}
+
+TextWriter& TextWriter::AppendFixed(float Value, uint8_t Decimals)
+{
+  if (Value != Value) return Append("nan");
+  if (Decimals > TEXT_MAX_DECIMALS) Decimals = TEXT_MAX_DECIMALS;
+
+  bool Negative = Value < 0.0f;
+  double Scaled = (Negative ? -double(Value) : double(Value)) * Pow10[Decimals] + 0.5;
+  if (Scaled > 1.8e19) return Append(Value > 3.4e38f || Value < -3.4e38f ? (Negative ? "-inf" : "inf") : "ovf");
+
+  uint64_t Fixed = uint64_t(Scaled);
+  if (Negative && Fixed != 0) Append('-');
+
+  AppendDigits(Fixed / Pow10[Decimals], 1);
+  if (Decimals == 0) return *this;
+
+  Append('.');
+  return AppendDigits(Fixed % Pow10[Decimals], Decimals);
+}
+
+void TextWriter::Clear(void)
+{
+  Length = 0;
+  Truncated = false;
+  Buffer[0] = '\0';
+}
+
+TextWriter& TextWriter::AppendDigits(uint64_t Value, uint8_t MinDigits)
+{
+  // Filled from the end, 20 digits hold any uint64_t
+  char Digits[21];
+  char* Cursor = &Digits[sizeof(Digits) - 1];
+  *Cursor = '\0';
+
+  do
+  {
+    *--Cursor = char('0' + Value % 10);
+    Value /= 10;
+  } while (Value != 0 || &Digits[sizeof(Digits) - 1] - Cursor < MinDigits);
+
+  return Append(Cursor);
+}
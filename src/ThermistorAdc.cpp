@@ -0,0 +1,57 @@
+#include "ThermistorAdc.h"
+
+uint16_t ThermistorAdcDecimate(const volatile uint16_t* Samples, uint32_t Count)
+{
+  if (Count == 0) return 0;
+
+  uint32_t Sum = 0;
+  for (uint32_t i = 0; i < Count; i++) Sum += Samples[i];
+  return uint16_t((Sum + Count / 2) / Count);
+}
+
+void ThermistorAdc::Reset(const uint8_t* Pins, uint8_t Count)
+{
+  if (Count > THERMISTOR_ADC_CHANNELS) Count = THERMISTOR_ADC_CHANNELS;
+  ChannelCount = Count > 0 ? Count : 1;
+  Active = 0;
+  for (uint8_t Channel = 0; Channel < THERMISTOR_ADC_CHANNELS; Channel++)
+  {
+    this->Pins[Channel] = Channel < Count ? Pins[Channel] : Pins[0];
+    Code[Channel] = 0;
+    Time[Channel] = 0;
+    Sequence[Channel] = 0;
+  }
+}
+
+ThermistorAdcReading ThermistorAdc::GetLatest(uint8_t Channel) const
+{
+  ThermistorAdcReading Reading;
+  uint32_t Start;
+  do
+  {
+    Start = Sequence[Channel];
+    Reading.Code = Code[Channel];
+    Reading.Time = Time[Channel];
+  } while ((Start & 1) || Start != Sequence[Channel]);
+
+  return Reading;
+}
+
+uint8_t ThermistorAdc::OnBlockComplete(const volatile uint16_t* Samples, uint32_t Count, uint64_t BlockTime)
+{
+  uint8_t Channel = Active;
+
+  // The first conversions of a block may still belong to the previous channel
+  if (Count > THERMISTOR_ADC_SETTLE_SAMPLES)
+  {
+    uint16_t Decimated = ThermistorAdcDecimate(Samples + THERMISTOR_ADC_SETTLE_SAMPLES, Count - THERMISTOR_ADC_SETTLE_SAMPLES);
+
+    Sequence[Channel] = Sequence[Channel] + 1;
+    Code[Channel] = Decimated;
+    Time[Channel] = BlockTime;
+    Sequence[Channel] = Sequence[Channel] + 1;
+  }
+
+  Active = (Channel + 1) % ChannelCount;
+  return Active;
+}
@@ -0,0 +1,55 @@
+#if defined(__IMXRT1062__)
+
+#include <Arduino.h>
+#include <ADC.h>
+#include <DMAChannel.h>
+
+#include "Clock.h"
+#include "ThermistorAdc.h"
+
+// The thermistor pins (A10/A11) are only wired to ADC1, so one ADC cycles through every channel.
+// Every analog channel must be on A0-A11 for the same reason.
+static ADC Adc;
+static DMAChannel Dma;
+static ThermistorAdc* Engine;
+
+DMAMEM static volatile uint16_t __attribute__((aligned(32))) Buffer[2 * THERMISTOR_ADC_BLOCK_SIZE];
+
+static void ThermistorAdcDmaIsr(void)
+{
+  uint64_t Time = ClockMicros();
+  Dma.clearInterrupt();
+
+  // DMA is already filling one half, the other one just completed
+  volatile uint16_t* Filling = (volatile uint16_t*) Dma.destinationAddress();
+  volatile uint16_t* Block = (Filling >= &Buffer[THERMISTOR_ADC_BLOCK_SIZE]) ? &Buffer[0] : &Buffer[THERMISTOR_ADC_BLOCK_SIZE];
+  arm_dcache_delete((void*) Block, THERMISTOR_ADC_BLOCK_SIZE * sizeof(Buffer[0]));
+
+  uint8_t Next = Engine->OnBlockComplete(Block, THERMISTOR_ADC_BLOCK_SIZE, Time);
+  Adc.adc0->startContinuous(Engine->GetPin(Next));
+}
+
+void ThermistorAdc::Begin(const uint8_t* Pins, uint8_t Count)
+{
+  Reset(Pins, Count);
+  Engine = this;
+
+  Adc.adc0->setResolution(THERMISTOR_ADC_RESOLUTION);
+  Adc.adc0->setAveraging(THERMISTOR_ADC_AVERAGING);
+  Adc.adc0->setConversionSpeed(ADC_CONVERSION_SPEED::MED_SPEED);
+  Adc.adc0->setSamplingSpeed(ADC_SAMPLING_SPEED::MED_SPEED);
+
+  Dma.begin();
+  Dma.source((volatile uint16_t&) ADC1_R0);
+  Dma.destinationBuffer(Buffer, sizeof(Buffer));
+  Dma.interruptAtHalf();
+  Dma.interruptAtCompletion();
+  Dma.triggerAtHardwareEvent(DMAMUX_SOURCE_ADC1);
+  Dma.attachInterrupt(ThermistorAdcDmaIsr);
+  Dma.enable();
+
+  Adc.adc0->enableDMA();
+  Adc.adc0->startContinuous(GetPin(GetActiveChannel()));
+}
+
+#endif
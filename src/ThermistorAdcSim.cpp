@@ -0,0 +1,34 @@
+#if !defined(ARDUINO)
+
+#include "ThermistorAdcSim.h"
+
+static ThermistorAdc* Instance = nullptr;
+
+void ThermistorAdc::Begin(const uint8_t* Pins, uint8_t Count)
+{
+  Reset(Pins, Count);
+  Instance = this;
+}
+
+ThermistorAdc* ThermistorAdcSimInstance(void)
+{
+  return Instance;
+}
+
+void ThermistorAdcSimulateBlock(ThermistorAdc& Adc, ThermistorAdcSource Source, void* Context, uint64_t Time)
+{
+  uint16_t Block[THERMISTOR_ADC_BLOCK_SIZE];
+  uint8_t Pin = Adc.GetPin(Adc.GetActiveChannel());
+
+  for (uint32_t i = 0; i < THERMISTOR_ADC_BLOCK_SIZE; i++)
+  {
+    // Hardware averaging, one sample is the mean of several raw conversions
+    uint32_t Sum = 0;
+    for (uint32_t j = 0; j < THERMISTOR_ADC_AVERAGING; j++) Sum += Source(Context, Pin);
+    Block[i] = uint16_t((Sum + THERMISTOR_ADC_AVERAGING / 2) / THERMISTOR_ADC_AVERAGING);
+  }
+
+  Adc.OnBlockComplete(Block, THERMISTOR_ADC_BLOCK_SIZE, Time);
+}
+
+#endif
@@ -0,0 +1,69 @@
+#include "ThrustAnalyzer.h"
+
+void ThrustAnalyzer::Reset(void)
+{
+  Results = ThrustResults{};
+  HasPrevious = false;
+  PreviousTime = 0;
+  PreviousForce = 0;
+}
+
+void ThrustAnalyzer::Update(uint64_t Time, float Force)
+{
+  bool WasBurning = IsBurning();
+
+  if (!WasBurning && Force >= OnsetThreshold)
+  {
+    if (!Results.Ignited) Results.OnsetTime = Time;
+    Results.Ignited = true;
+    Results.BurnedOut = false;
+  }
+  else if (WasBurning && Force < BurnoutThreshold)
+  {
+    Results.BurnedOut = true;
+    Results.BurnoutTime = Time;
+  }
+
+  // The interval that crosses the onset threshold belongs to the burn as well
+  if (HasPrevious && Time > PreviousTime && (WasBurning || IsBurning()))
+  {
+    float Interval = float(Time - PreviousTime) * 1e-6f;
+    Results.TotalImpulse += 0.5f * (Force + PreviousForce) * Interval;
+  }
+
+  if (Force > Results.PeakThrust)
+  {
+    Results.PeakThrust = Force;
+    Results.PeakTime = Time;
+  }
+
+  if (Results.Ignited)
+  {
+    uint64_t End = Results.BurnedOut ? Results.BurnoutTime : Time;
+    Results.BurnTime = float(End - Results.OnsetTime) * 1e-6f;
+    Results.AverageThrust = Results.BurnTime > 0 ? Results.TotalImpulse / Results.BurnTime : 0;
+  }
+
+  HasPrevious = true;
+  PreviousTime = Time;
+  PreviousForce = Force;
+}
+
+const char* ThrustAnalyzer::MotorClass(float TotalImpulse)
+{
+  static const char* const Classes[] = {
+    "1/8A", "1/4A", "1/2A", "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M", "N", "O"
+  };
+  const uint8_t ClassCount = sizeof(Classes) / sizeof(Classes[0]);
+
+  if (TotalImpulse <= 0) return "-";
+
+  // Each class doubles the upper bound, 1/8A ends at 0.3125 Ns
+  float Upper = 0.3125f;
+  for (uint8_t i = 0; i < ClassCount; i++)
+  {
+    if (TotalImpulse <= Upper) return Classes[i];
+    Upper *= 2;
+  }
+  return ">O";
+}
@@ -0,0 +1,30 @@
+#include "TriggerEngine.h"
+
+void TriggerEngine::Arm(uint64_t Time)
+{
+  Armed = true;
+  Triggered = false;
+  Above = 0;
+  CommandTime = Time;
+  TriggerTime = 0;
+}
+
+bool TriggerEngine::Update(uint64_t Time, float Force)
+{
+  if (!Armed || Triggered) return false;
+
+  // Samples converted before the relay closed cannot be the ignition
+  if (Time < CommandTime) return false;
+
+  if (Force < Threshold)
+  {
+    Above = 0;
+    return false;
+  }
+
+  if (Above == 0) TriggerTime = Time;
+  Above++;
+
+  Triggered = Above >= ConfirmSamples;
+  return Triggered;
+}
@@ -0,0 +1,61 @@
+#if !defined(ARDUINO)
+
+#include "Benchmark.h"
+#include "HalSim.h"
+
+#include <chrono>
+
+static double TimeBatch(const Benchmark& Entry, uint32_t Iterations)
+{
+  auto Start = std::chrono::steady_clock::now();
+  Entry.Function(Iterations);
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+}
+
+BenchmarkResult BenchmarkRun(const Benchmark& Entry, double MinTime)
+{
+  BenchmarkResult Result{};
+  Result.Name = Entry.Name;
+
+  // Warm up and size the batch
+  uint32_t Iterations = 16;
+  while (Iterations < (1u << 30))
+  {
+    double Elapsed = TimeBatch(Entry, Iterations);
+    if (Elapsed >= MinTime) break;
+
+    double Scale = Elapsed > 0.0 ? MinTime / Elapsed * 1.2 : 16.0;
+    Iterations = uint32_t(Iterations * (Scale > 16.0 ? 16.0 : Scale < 2.0 ? 2.0 : Scale));
+  }
+  Result.Iterations = Iterations;
+
+  double Best = 1e300;
+  uint64_t Allocations = HalSimAllocations();
+  for (uint32_t i = 0; i < BENCHMARK_REPEATS; i++)
+  {
+    double Elapsed = TimeBatch(Entry, Iterations);
+    if (Elapsed < Best) Best = Elapsed;
+  }
+  Allocations = HalSimAllocations() - Allocations;
+
+  Result.NsPerOp = Best * 1e9 / Iterations;
+  Result.AllocationsPerOp = double(Allocations) / (double(Iterations) * BENCHMARK_REPEATS);
+  return Result;
+}
+
+void BenchmarkWriteJson(FILE* Out, const BenchmarkResult* Results, uint32_t Count)
+{
+  fprintf(Out, "{\n  \"benchmarks\": [\n");
+  for (uint32_t i = 0; i < Count; i++)
+  {
+    fprintf(Out, "    { \"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"allocs_per_op\": %.3f }%s\n",
+      Results[i].Name,
+      (unsigned long long) Results[i].Iterations,
+      Results[i].NsPerOp,
+      Results[i].AllocationsPerOp,
+      i + 1 < Count ? "," : "");
+  }
+  fprintf(Out, "  ]\n}\n");
+}
+
+#endif
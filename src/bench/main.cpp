@@ -0,0 +1,536 @@
+#if !defined(ARDUINO)
+
+#include "Benchmark.h"
+#include "BoundedQueue.h"
+#include "BurnoutDetector.h"
+#include "CaptureArena.h"
+#include "Channels.h"
+#include "Config.h"
+#include "ForceFilter.h"
+#include "HalSim.h"
+#include "Hx711Array.h"
+#include "LogRecorder.h"
+#include "Profiler.h"
+#include "RingBuffer.h"
+#include "SpscQueue.h"
+#include "Telemetry.h"
+#include "TextBuffer.h"
+#include "Thermistor.h"
+#include "ThermistorAdc.h"
+#include "ThrustAnalyzer.h"
+#include "TriggerEngine.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+/* Per-sample hot path benchmarks
+*
+* Usage: program [--json FILE] [--filter TEXT] [--min-time SECONDS]
+*
+* std::string stands in for the Arduino String the firmware used to format records
+* and display values; both grow on the heap the same way.
+*/
+
+#define BENCH_INPUT_SIZE                1024    // Power of two
+#define BENCH_SAMPLE_PERIOD             12500   // us, 80 SPS
+
+static float Forces[BENCH_INPUT_SIZE];
+static uint16_t Codes[BENCH_INPUT_SIZE];
+static LogRecord Records[BENCH_INPUT_SIZE];
+static Hx711Levels Levels[HX711_DATA_BITS + 1];
+static constexpr ThermistorTable Table(THERMISTOR_1_RESISTANCE, THERMISTOR_CALIBRATION_OFFSET);
+
+static void PrepareInputs(void)
+{
+  srand(1);
+  for (uint32_t i = 0; i < BENCH_INPUT_SIZE; i++)
+  {
+    Forces[i] = float(100.0 * sin(M_PI * i / BENCH_INPUT_SIZE) + (rand() % 100) * 0.01);
+    Codes[i] = uint16_t(1000 + rand() % 2000);
+    Records[i].Time = uint64_t(i) * BENCH_SAMPLE_PERIOD;
+    SensorChannels::Set<ForceChannel>(Records[i], Forces[i]);
+    SensorChannels::Set<Thermistor1Channel>(Records[i], 21.5f + i * 0.01f);
+    SensorChannels::Set<Thermistor2Channel>(Records[i], 22.25f);
+    SensorChannels::Set<TemperatureAgeChannel>(Records[i], 1500);
+  }
+
+  // Ready check first, then one level per data pulse
+  Levels[0] = 0;
+  for (uint32_t i = 1; i <= HX711_DATA_BITS; i++) Levels[i] = Hx711Levels(rand() & 0x0F);
+}
+
+/* Thermistor */
+
+static void ThermistorFormula(uint32_t Iterations)
+{
+  // ReadThermistor() before the lookup table
+  const float c1 = 1.009249522e-03, c2 = 2.378405444e-04, c3 = 2.019202697e-07;
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    float Vo = (3.3f / 1024.0f) * (Codes[i % BENCH_INPUT_SIZE] >> 2);
+    float R1 = float(THERMISTOR_1_RESISTANCE) * (3.3f - Vo) / Vo;
+    float logR2 = log(R1);
+    float T = (1.0 / (c1 + c2 * logR2 + c3 * logR2 * logR2 * logR2));
+    T = T - 273.15f + THERMISTOR_CALIBRATION_OFFSET;
+    BenchmarkKeep(T);
+  }
+}
+
+static void ThermistorTableConvert(uint32_t Iterations)
+{
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    float T = Table.Convert(Codes[i % BENCH_INPUT_SIZE], THERMISTOR_ADC_RESOLUTION);
+    BenchmarkKeep(T);
+  }
+}
+
+static void AnalogChannelsPoll(uint32_t Iterations)
+{
+  // The analog task, every channel due on every run
+  static ThermistorAdc Adc;
+  static SensorChannels Channels;
+  Channels.Begin(Adc);
+  for (uint8_t i = 0; i < SensorChannels::ADC_COUNT; i++) Adc.OnBlockComplete(Codes, THERMISTOR_ADC_BLOCK_SIZE, i);
+
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    Channels.Poll(Adc);
+    BenchmarkKeep(Channels);
+  }
+}
+
+/* Load cell */
+
+static void LoadCellScale(uint32_t Iterations)
+{
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    float Force = Forces[i % BENCH_INPUT_SIZE] * 100000.f / 100000.f;
+    BenchmarkKeep(Force);
+  }
+}
+
+// DOUT levels from memory, so only the clock-out and decode are measured
+class BenchHx711Port
+{
+public:
+  Hx711Levels Read(void)
+  {
+    Hx711Levels Level = Levels[Pulse];
+    Pulse = Pulse == HX711_DATA_BITS ? 0 : Pulse + 1;
+    return Level;
+  }
+
+  void Clock(bool Level) { Sck = Level; }
+  void Wait(void) {}
+
+private:
+  uint8_t Pulse = 0;
+  volatile bool Sck = false;
+};
+
+static void LoadCellHx711Read(uint8_t Count, uint32_t Iterations)
+{
+  Hx711Array Cells;
+  BenchHx711Port Port;
+  Cells.Begin(Count, 1.0f);
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    Cells.Update(Port);
+    BenchmarkKeep(Cells);
+  }
+}
+
+static void LoadCellHx711Read1(uint32_t Iterations)
+{
+  LoadCellHx711Read(1, Iterations);
+}
+
+static void LoadCellHx711Read4(uint32_t Iterations)
+{
+  LoadCellHx711Read(4, Iterations);
+}
+
+static void LoadCellQueuePushPop(uint32_t Iterations)
+{
+  static SpscQueue<LoadCellSample, 64> Queue;
+  LoadCellSample Sample;
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    Queue.Push({ uint64_t(i) * BENCH_SAMPLE_PERIOD, Forces[i % BENCH_INPUT_SIZE], Forces[i % BENCH_INPUT_SIZE], {} });
+    Queue.Pop(Sample);
+    BenchmarkKeep(Sample);
+  }
+}
+
+/* Force filter, per sample in blocks like GetLoadCellData() */
+
+static void ForceFilterRun(E_FORCE_FILTER Type, uint32_t Iterations)
+{
+  static ForceFilter Filter;
+  Filter.Begin(Type, FORCE_FILTER_SAMPLE_RATE, FORCE_FILTER_CUTOFF, FORCE_FILTER_LENGTH);
+
+  float Block[FORCE_FILTER_BLOCK_SIZE];
+  for (uint32_t i = 0; i < Iterations; i += FORCE_FILTER_BLOCK_SIZE)
+  {
+    uint32_t Count = Iterations - i < FORCE_FILTER_BLOCK_SIZE ? Iterations - i : FORCE_FILTER_BLOCK_SIZE;
+    memcpy(Block, &Forces[i % BENCH_INPUT_SIZE], Count * sizeof(Block[0]));
+    Filter.Process(Block, Block, Count);
+    BenchmarkKeep(Block);
+  }
+}
+
+static void ForceFilterBiquad(uint32_t Iterations)
+{
+  ForceFilterRun(FORCE_FILTER_BIQUAD, Iterations);
+}
+
+static void ForceFilterFir(uint32_t Iterations)
+{
+  ForceFilterRun(FORCE_FILTER_FIR, Iterations);
+}
+
+static void ForceFilterMedian(uint32_t Iterations)
+{
+  ForceFilterRun(FORCE_FILTER_MEDIAN, Iterations);
+}
+
+/* Record formatting */
+
+static void AppendFloat(std::string& Text, double Value)
+{
+  // String::append(double) prints two decimals
+  char Digits[24];
+  snprintf(Digits, sizeof(Digits), "%.2f", Value);
+  Text.append(Digits);
+}
+
+static void RecordFormatString(uint32_t Iterations)
+{
+  // The CSV line LogTestData() used to build per sample
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    const LogRecord& Record = Records[i % BENCH_INPUT_SIZE];
+    std::string TelemetryString;
+    AppendFloat(TelemetryString, Record.Time / 1e6);
+    TelemetryString.append(", ");
+    AppendFloat(TelemetryString, SensorChannels::Get<ForceChannel>(Record));
+    TelemetryString.append(", ");
+    AppendFloat(TelemetryString, SensorChannels::Get<Thermistor1Channel>(Record));
+    TelemetryString.append(", ");
+    AppendFloat(TelemetryString, SensorChannels::Get<Thermistor2Channel>(Record));
+    TelemetryString.append("\n");
+    BenchmarkKeep(TelemetryString);
+  }
+}
+
+static void RecordFormatSnprintf(uint32_t Iterations)
+{
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    const LogRecord& Record = Records[i % BENCH_INPUT_SIZE];
+    char Line[64];
+    snprintf(Line, sizeof(Line), "%.6f, %.2f, %.2f, %.2f\n",
+      Record.Time / 1e6, double(SensorChannels::Get<ForceChannel>(Record)),
+      double(SensorChannels::Get<Thermistor1Channel>(Record)), double(SensorChannels::Get<Thermistor2Channel>(Record)));
+    BenchmarkKeep(Line);
+  }
+}
+
+static void RecordFormatFixed(uint32_t Iterations)
+{
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    const LogRecord& Record = Records[i % BENCH_INPUT_SIZE];
+    TextBuffer<64> Line;
+    Line.AppendFixed(Record.Time / 1e6f, 6).Append(", ")
+      .AppendFixed(SensorChannels::Get<ForceChannel>(Record), 2).Append(", ")
+      .AppendFixed(SensorChannels::Get<Thermistor1Channel>(Record), 2).Append(", ")
+      .AppendFixed(SensorChannels::Get<Thermistor2Channel>(Record), 2).Append('\n');
+    BenchmarkKeep(Line);
+  }
+}
+
+static void RecordChannelsFill(uint32_t Iterations)
+{
+  // CreateLogRecord(), the analog values are copied as one block
+  static SensorChannels Channels;
+  LogRecord Record;
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    LoadCellSample Sample = { uint64_t(i) * BENCH_SAMPLE_PERIOD, Forces[i % BENCH_INPUT_SIZE], Forces[i % BENCH_INPUT_SIZE], {} };
+    Channels.Fill(Record, Sample);
+    BenchmarkKeep(Record);
+  }
+}
+
+static void RecordCaptureAppend(uint32_t Iterations)
+{
+  static CaptureArena Capture;
+  if (!Capture.IsAvailable()) Capture.Begin();
+
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    if (!Capture.Append(&Records[i % BENCH_INPUT_SIZE], sizeof(LogRecord))) Capture.Clear();
+  }
+}
+
+static void RecordRecorderPushDrain(uint32_t Iterations)
+{
+  static HalFile File;
+  static LogRecorder Recorder;
+  if (!File.IsOpen())
+  {
+    File.Open("Benchmark.bin");
+    File.PreAllocate(CAPTURE_ARENA_SIZE);
+    Recorder.Begin(&File);
+  }
+
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    Recorder.Push(Records[i % BENCH_INPUT_SIZE]);
+    Recorder.Drain();
+
+    // Wrap inside the preallocated size
+    if (Recorder.GetFileOffset() >= CAPTURE_ARENA_SIZE - RECORDER_BUFFER_SIZE)
+    {
+      Recorder.Flush();
+      File.SeekSet(0);
+      Recorder.Begin(&File);
+    }
+  }
+}
+
+/* Pipeline */
+
+static void PipelineFanOut(uint32_t Iterations)
+{
+  // One producer, three consumers taking their samples in batches as their tasks would
+  static BoundedQueue<LogRecord, PIPELINE_LOG_DEPTH> Log(PIPELINE_LOG_POLICY);
+  static BoundedQueue<LogRecord, PIPELINE_TELEMETRY_DEPTH> Telemetry(PIPELINE_TELEMETRY_POLICY);
+  static BoundedQueue<LogRecord, PIPELINE_DISPLAY_DEPTH> Display(PIPELINE_DISPLAY_POLICY);
+
+  LogRecord Record;
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    const LogRecord& Sample = Records[i % BENCH_INPUT_SIZE];
+    Log.Push(Sample);
+    Telemetry.Push(Sample);
+    Display.Push(Sample);
+
+    if (i % 4 == 3)
+    {
+      while (Log.Pop(Record)) BenchmarkKeep(Record);
+      while (Telemetry.Pop(Record)) BenchmarkKeep(Record);
+      while (Display.Pop(Record)) BenchmarkKeep(Record);
+    }
+  }
+}
+
+/* Telemetry */
+
+static void DiscardConsole(const void* Data, size_t Size, void* Context)
+{
+  (void) Data;
+  (void) Size;
+  (void) Context;
+}
+
+static void TelemetrySendService(uint32_t Iterations)
+{
+  static TelemetryStream Stream;
+  HalSimSetConsoleSink(DiscardConsole, nullptr);
+
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    const LogRecord& Record = Records[i % BENCH_INPUT_SIZE];
+    uint8_t Payload[SensorChannels::DATA_SIZE + 1];
+    memcpy(Payload, Record.Data, SensorChannels::DATA_SIZE);
+    Payload[SensorChannels::DATA_SIZE] = 4;
+    Stream.Send(TELEMETRY_SAMPLE, Record.Time, Payload, sizeof(Payload));
+
+    // The task services at a fraction of the sample rate
+    if (i % 4 == 3) Stream.Service();
+  }
+}
+
+/* Buffers */
+
+static void RingBufferPushPop(uint32_t Iterations)
+{
+  static RingBuffer<LogRecord, PRETRIGGER_SECONDS * PRETRIGGER_SAMPLE_RATE> History;
+  LogRecord Record;
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    History.Push(Records[i % BENCH_INPUT_SIZE]);
+    History.Pop(Record);
+    BenchmarkKeep(Record);
+  }
+}
+
+static void RingBufferOverwrite(uint32_t Iterations)
+{
+  // Steady state during the countdown, the history is full and every push drops the oldest
+  static RingBuffer<LogRecord, PRETRIGGER_SECONDS * PRETRIGGER_SAMPLE_RATE> History;
+  for (uint32_t i = 0; i < Iterations; i++) History.Push(Records[i % BENCH_INPUT_SIZE]);
+  BenchmarkKeep(History);
+}
+
+/* Analysis */
+
+static void AnalyzerUpdate(uint32_t Iterations)
+{
+  ThrustAnalyzer Analyzer(ANALYSIS_ONSET_THRESHOLD, ANALYSIS_BURNOUT_THRESHOLD);
+  for (uint32_t i = 0; i < Iterations; i++) Analyzer.Update(uint64_t(i) * BENCH_SAMPLE_PERIOD, Forces[i % BENCH_INPUT_SIZE]);
+  BenchmarkKeep(Analyzer.GetResults());
+}
+
+static void BurnoutUpdate(uint32_t Iterations)
+{
+  BurnoutDetector Burnout(uint32_t(BURNOUT_FILTER_TIME_CONSTANT * 1e6f), BURNOUT_ONSET_THRESHOLD, BURNOUT_THRESHOLD,
+    uint32_t(BURNOUT_HOLDOFF_SECONDS * 1e6f));
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    bool BurnedOut = Burnout.Update(uint64_t(i) * BENCH_SAMPLE_PERIOD, Forces[i % BENCH_INPUT_SIZE]);
+    BenchmarkKeep(BurnedOut);
+  }
+}
+
+static void TriggerUpdate(uint32_t Iterations)
+{
+  // Armed and waiting, the path every sample takes until thrust onset
+  TriggerEngine Trigger(TRIGGER_THRESHOLD, TRIGGER_CONFIRM_SAMPLES);
+  Trigger.Arm(0);
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    bool Fired = Trigger.Update(uint64_t(i) * BENCH_SAMPLE_PERIOD, Forces[i % BENCH_INPUT_SIZE] * 0.01f);
+    BenchmarkKeep(Fired);
+  }
+}
+
+/* Display */
+
+static void DisplayFormatString(uint32_t Iterations)
+{
+  // String(LoadCellForceData).c_str() and friends
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    std::string Value;
+    AppendFloat(Value, Forces[i % BENCH_INPUT_SIZE]);
+    BenchmarkKeep(Value);
+  }
+}
+
+static void DisplayFormatSnprintf(uint32_t Iterations)
+{
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    char Value[16];
+    snprintf(Value, sizeof(Value), "%.2f", double(Forces[i % BENCH_INPUT_SIZE]));
+    BenchmarkKeep(Value);
+  }
+}
+
+static void DisplayFormatFixed(uint32_t Iterations)
+{
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    TextBuffer<16> Value;
+    Value.AppendFixed(Forces[i % BENCH_INPUT_SIZE], 2);
+    BenchmarkKeep(Value);
+  }
+}
+
+/* Profiler */
+
+static void ProfilerScope(uint32_t Iterations)
+{
+  for (uint32_t i = 0; i < Iterations; i++)
+  {
+    PROFILE_SCOPE(PROFILE_STATE);
+  }
+}
+
+static const Benchmark Benchmarks[] = {
+  { "thermistor/formula_libm",      ThermistorFormula },
+  { "thermistor/table_convert",     ThermistorTableConvert },
+  { "analog/channels_poll",         AnalogChannelsPoll },
+  { "load_cell/scale",              LoadCellScale },
+  { "load_cell/queue_push_pop",     LoadCellQueuePushPop },
+  { "load_cell/hx711_read_1",       LoadCellHx711Read1 },
+  { "load_cell/hx711_read_4",       LoadCellHx711Read4 },
+  { "filter/biquad",                ForceFilterBiquad },
+  { "filter/fir",                   ForceFilterFir },
+  { "filter/median",                ForceFilterMedian },
+  { "record/format_string",         RecordFormatString },
+  { "record/format_snprintf",       RecordFormatSnprintf },
+  { "record/format_fixed",          RecordFormatFixed },
+  { "record/channels_fill",         RecordChannelsFill },
+  { "record/capture_append",        RecordCaptureAppend },
+  { "record/recorder_push_drain",   RecordRecorderPushDrain },
+  { "pipeline/fan_out",             PipelineFanOut },
+  { "telemetry/send_service",       TelemetrySendService },
+  { "ring_buffer/push_pop",         RingBufferPushPop },
+  { "ring_buffer/overwrite",        RingBufferOverwrite },
+  { "analysis/thrust_analyzer",     AnalyzerUpdate },
+  { "analysis/burnout_detector",    BurnoutUpdate },
+  { "analysis/trigger_armed",       TriggerUpdate },
+  { "display/format_string",        DisplayFormatString },
+  { "display/format_snprintf",      DisplayFormatSnprintf },
+  { "display/format_fixed",         DisplayFormatFixed },
+  { "profiler/scope",               ProfilerScope },
+};
+
+int main(int argc, char** argv)
+{
+  const char* JsonPath = nullptr;
+  const char* Filter = nullptr;
+  double MinTime = BENCHMARK_MIN_TIME;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--json") && i + 1 < argc) JsonPath = argv[++i];
+    else if (!strcmp(argv[i], "--filter") && i + 1 < argc) Filter = argv[++i];
+    else if (!strcmp(argv[i], "--min-time") && i + 1 < argc) MinTime = atof(argv[++i]);
+    else
+    {
+      fprintf(stderr, "Usage: %s [--json FILE] [--filter TEXT] [--min-time SECONDS]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  PrepareInputs();
+
+  const uint32_t Count = sizeof(Benchmarks) / sizeof(Benchmarks[0]);
+  BenchmarkResult Results[Count];
+  uint32_t Ran = 0;
+
+  printf("%-30s %12s %12s %14s\n", "BENCHMARK", "NS/OP", "ALLOCS/OP", "ITERATIONS");
+  for (uint32_t i = 0; i < Count; i++)
+  {
+    if (Filter != nullptr && strstr(Benchmarks[i].Name, Filter) == nullptr) continue;
+
+    BenchmarkResult& Result = Results[Ran++];
+    Result = BenchmarkRun(Benchmarks[i], MinTime);
+    printf("%-30s %12.2f %12.2f %14llu\n", Result.Name, Result.NsPerOp, Result.AllocationsPerOp,
+      (unsigned long long) Result.Iterations);
+  }
+
+  if (JsonPath != nullptr)
+  {
+    FILE* Out = fopen(JsonPath, "w");
+    if (Out == nullptr)
+    {
+      fprintf(stderr, "Cannot write %s\n", JsonPath);
+      return 1;
+    }
+    BenchmarkWriteJson(Out, Results, Ran);
+    fclose(Out);
+  }
+  return 0;
+}
+
+#endif
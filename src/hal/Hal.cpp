@@ -0,0 +1,28 @@
+#include "Hal.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+size_t HalPrint::Print(const char* Text)
+{
+  return Write(Text, strlen(Text));
+}
+
+size_t HalPrint::Println(const char* Text)
+{
+  return Print(Text) + Write("\n", 1);
+}
+
+size_t HalPrint::Printf(const char* Format, ...)
+{
+  char Buffer[256];
+
+  va_list Arguments;
+  va_start(Arguments, Format);
+  int Length = vsnprintf(Buffer, sizeof(Buffer), Format, Arguments);
+  va_end(Arguments);
+
+  if (Length < 0) return 0;
+  return Write(Buffer, size_t(Length) < sizeof(Buffer) ? size_t(Length) : sizeof(Buffer) - 1);
+}
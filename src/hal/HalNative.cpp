@@ -0,0 +1,656 @@
+#if !defined(ARDUINO)
+
+#include "Clock.h"
+#include "Config.h"
+#include "Hal.h"
+#include "HalSim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+/* Heap */
+
+static uint64_t Allocations;
+static uint32_t HeapExempt;   // Nesting depth of simulator internals, their allocations are not the app's
+
+struct SimHeapExempt
+{
+  SimHeapExempt() { HeapExempt++; }
+  ~SimHeapExempt() { HeapExempt--; }
+};
+
+static void CountAllocation(void)
+{
+  if (HeapExempt == 0) Allocations++;
+}
+
+#if defined(__GLIBC__)
+extern "C" void* __libc_malloc(size_t Size);
+extern "C" void* __libc_calloc(size_t Count, size_t Size);
+extern "C" void* __libc_realloc(void* Block, size_t Size);
+
+// Interposed so C allocations count too; operator new sits on malloc
+extern "C" void* malloc(size_t Size) noexcept
+{
+  CountAllocation();
+  return __libc_malloc(Size);
+}
+
+extern "C" void* calloc(size_t Count, size_t Size) noexcept
+{
+  CountAllocation();
+  return __libc_calloc(Count, Size);
+}
+
+extern "C" void* realloc(void* Block, size_t Size) noexcept
+{
+  CountAllocation();
+  return __libc_realloc(Block, Size);
+}
+#else
+void* operator new(size_t Size)
+{
+  CountAllocation();
+  void* Block = malloc(Size ? Size : 1);
+  if (Block == nullptr) throw std::bad_alloc();
+  return Block;
+}
+
+void* operator new[](size_t Size)
+{
+  return operator new(Size);
+}
+
+void operator delete(void* Block) noexcept
+{
+  free(Block);
+}
+
+void operator delete[](void* Block) noexcept
+{
+  free(Block);
+}
+
+void operator delete(void* Block, size_t Size) noexcept
+{
+  (void) Size;
+  free(Block);
+}
+
+void operator delete[](void* Block, size_t Size) noexcept
+{
+  (void) Size;
+  free(Block);
+}
+#endif
+
+uint64_t HalSimAllocations(void)
+{
+  return Allocations;
+}
+
+/* Clock */
+
+static uint64_t Now;
+
+void ClockBegin(void)
+{
+}
+
+uint64_t ClockCycles(void)
+{
+  return Now * HAL_SIM_CPU_MHZ;
+}
+
+uint64_t ClockMicros(void)
+{
+  return Now;
+}
+
+/* PSRAM */
+
+static bool PsramFitted = true;
+
+void HalSimSetPsram(bool Fitted)
+{
+  PsramFitted = Fitted;
+}
+
+bool HalSimHasPsram(void)
+{
+  return PsramFitted;
+}
+
+/* Console */
+
+static HalSimConsoleSink ConsoleSink;
+static void* ConsoleContext;
+static uint32_t ConsoleRate;        // Bytes/s the host reads, 0 when unlimited
+static uint64_t ConsoleDrained;     // When everything written so far has left the TX buffer
+
+class SimConsole : public HalPrint
+{
+public:
+  size_t Write(const void* Data, size_t Size) override
+  {
+    SimHeapExempt Exempt;
+    if (ConsoleRate != 0)
+    {
+      uint64_t Start = ConsoleDrained > Now ? ConsoleDrained : Now;
+      ConsoleDrained = Start + uint64_t(Size) * 1000000 / ConsoleRate;
+    }
+
+    if (ConsoleSink == nullptr) return fwrite(Data, 1, Size, stdout);
+    ConsoleSink(Data, Size, ConsoleContext);
+    return Size;
+  }
+};
+
+static SimConsole Console;
+
+void HalConsoleBegin(uint32_t Baud)
+{
+  (void) Baud;
+}
+
+HalPrint& HalConsole(void)
+{
+  return Console;
+}
+
+size_t HalConsoleWriteAvailable(void)
+{
+  if (ConsoleRate == 0 || ConsoleDrained <= Now) return HAL_SIM_CONSOLE_BUFFER_SIZE;
+
+  uint64_t Queued = (ConsoleDrained - Now) * ConsoleRate / 1000000;
+  return Queued < HAL_SIM_CONSOLE_BUFFER_SIZE ? HAL_SIM_CONSOLE_BUFFER_SIZE - Queued : 0;
+}
+
+void HalSimSetConsoleSink(HalSimConsoleSink Sink, void* Context)
+{
+  ConsoleSink = Sink;
+  ConsoleContext = Context;
+}
+
+void HalSimSetConsoleRate(uint32_t BytesPerSecond)
+{
+  ConsoleRate = BytesPerSecond;
+}
+
+/* GPIO */
+
+struct SimPin
+{
+  bool Level;
+  void (*Isr)(void);
+  E_HAL_INTERRUPT Mode;
+};
+
+struct SimPinChange
+{
+  uint64_t Time;
+  uint8_t Pin;
+  bool Level;
+  bool Pending;
+};
+
+static SimPin Pins[256];
+static SimPinChange PinChanges[HAL_SIM_PIN_CHANGES];
+static uint32_t RandomState = 1;
+
+static void SetPinLevel(uint8_t Pin, bool Level)
+{
+  bool Previous = Pins[Pin].Level;
+  Pins[Pin].Level = Level;
+  if (Pins[Pin].Isr == nullptr) return;
+
+  switch (Pins[Pin].Mode)
+  {
+  case HAL_INTERRUPT_RISING:
+  case HAL_INTERRUPT_HIGH:
+    if (!Previous && Level) Pins[Pin].Isr();
+    break;
+
+  case HAL_INTERRUPT_FALLING:
+    if (Previous && !Level) Pins[Pin].Isr();
+    break;
+  }
+}
+
+void HalPinMode(uint8_t Pin, E_HAL_PIN_MODE Mode)
+{
+  (void) Pin;
+  (void) Mode;
+}
+
+void HalDigitalWrite(uint8_t Pin, bool Level)
+{
+  Pins[Pin].Level = Level;
+}
+
+bool HalDigitalRead(uint8_t Pin)
+{
+  return Pins[Pin].Level;
+}
+
+void HalAttachInterrupt(uint8_t Pin, void (*Isr)(void), E_HAL_INTERRUPT Mode)
+{
+  Pins[Pin].Isr = Isr;
+  Pins[Pin].Mode = Mode;
+}
+
+uint32_t HalRandom(uint32_t Max)
+{
+  // Fixed LCG so every run names its files the same way
+  RandomState = RandomState * 1103515245u + 12345u;
+  return Max ? (RandomState >> 16) % Max : 0;
+}
+
+void HalSimSetPin(uint8_t Pin, bool Level)
+{
+  SetPinLevel(Pin, Level);
+}
+
+bool HalSimGetPin(uint8_t Pin)
+{
+  return Pins[Pin].Level;
+}
+
+bool HalSimSchedulePin(uint8_t Pin, bool Level, uint64_t Time)
+{
+  for (SimPinChange& Change : PinChanges)
+  {
+    if (Change.Pending) continue;
+    Change = { Time, Pin, Level, true };
+    return true;
+  }
+  return false;
+}
+
+static uint64_t NextPinChange(void)
+{
+  uint64_t Next = UINT64_MAX;
+  for (const SimPinChange& Change : PinChanges)
+  {
+    if (Change.Pending && Change.Time < Next) Next = Change.Time;
+  }
+  return Next;
+}
+
+/* File system */
+
+struct SimHandle
+{
+  std::vector<uint8_t>* Data;
+  uint32_t Position;
+};
+
+static std::map<std::string, std::vector<uint8_t>> Files;
+static SimHandle Handles[HAL_MAX_FILES];
+static uint32_t FileBlockTime;
+static uint64_t FileStallStart;
+static uint64_t FileStallEnd;
+
+static void FileBusy(size_t Size)
+{
+  uint64_t Busy = uint64_t((Size + HAL_SIM_FILE_BLOCK_SIZE - 1) / HAL_SIM_FILE_BLOCK_SIZE) * FileBlockTime;
+  if (Now >= FileStallStart && Now < FileStallEnd) Busy += FileStallEnd - Now;
+  if (Busy != 0) HalSimAdvanceTo(Now + Busy);
+}
+
+void HalSimSetFileTiming(uint32_t BlockTime, uint64_t StallStart, uint64_t StallDuration)
+{
+  FileBlockTime = BlockTime;
+  FileStallStart = StallStart;
+  FileStallEnd = StallStart + StallDuration;
+}
+
+bool HalFsBegin(void)
+{
+  return true;
+}
+
+bool HalFsExists(const char* Name)
+{
+  SimHeapExempt Exempt;
+  return Files.count(Name) != 0;
+}
+
+bool HalFsRemove(const char* Name)
+{
+  SimHeapExempt Exempt;
+  return Files.erase(Name) != 0;
+}
+
+bool HalFile::Open(const char* Name)
+{
+  SimHeapExempt Exempt;
+  if (IsOpen()) Close();
+
+  for (int8_t i = 0; i < HAL_MAX_FILES; i++)
+  {
+    if (Handles[i].Data != nullptr) continue;
+
+    std::vector<uint8_t>& Data = Files[Name];
+    Data.clear();
+    Handles[i] = { &Data, 0 };
+    Slot = i;
+    return true;
+  }
+  return false;
+}
+
+bool HalFile::Close(void)
+{
+  if (!IsOpen()) return false;
+
+  Handles[Slot].Data = nullptr;
+  Slot = -1;
+  return true;
+}
+
+size_t HalFile::Write(const void* Data, size_t Size)
+{
+  if (!IsOpen()) return 0;
+
+  SimHeapExempt Exempt;
+  SimHandle& Handle = Handles[Slot];
+  if (Handle.Position + Size > Handle.Data->size()) Handle.Data->resize(Handle.Position + Size);
+  memcpy(Handle.Data->data() + Handle.Position, Data, Size);
+  Handle.Position += uint32_t(Size);
+
+  FileBusy(Size);
+  return Size;
+}
+
+bool HalFile::Sync(void)
+{
+  if (!IsOpen()) return false;
+
+  // Directory entry and FAT update
+  FileBusy(HAL_SIM_FILE_BLOCK_SIZE);
+  return true;
+}
+
+bool HalFile::SeekSet(uint32_t Position)
+{
+  if (!IsOpen()) return false;
+
+  Handles[Slot].Position = Position;
+  return true;
+}
+
+bool HalFile::Truncate(uint32_t Length)
+{
+  if (!IsOpen()) return false;
+
+  SimHeapExempt Exempt;
+  SimHandle& Handle = Handles[Slot];
+  if (Length < Handle.Data->size()) Handle.Data->resize(Length);
+  if (Handle.Position > Length) Handle.Position = Length;
+  return true;
+}
+
+bool HalFile::PreAllocate(uint32_t Length)
+{
+  if (!IsOpen() || !Handles[Slot].Data->empty()) return false;
+
+  // Reserving keeps the test free of reallocations, like contiguous clusters keep it free of FAT updates
+  SimHeapExempt Exempt;
+  Handles[Slot].Data->reserve(Length);
+  return true;
+}
+
+uint32_t HalFile::GetPosition(void) const
+{
+  return IsOpen() ? Handles[Slot].Position : 0;
+}
+
+const uint8_t* HalSimReadFile(const char* Name, uint32_t* Size)
+{
+  SimHeapExempt Exempt;
+  auto Entry = Files.find(Name);
+  if (Entry == Files.end()) return nullptr;
+
+  *Size = uint32_t(Entry->second.size());
+  return Entry->second.data();
+}
+
+uint32_t HalSimDumpFiles(const char* Directory)
+{
+  SimHeapExempt Exempt;
+  uint32_t Written = 0;
+  for (const auto& Entry : Files)
+  {
+    std::string Path = std::string(Directory) + "/" + Entry.first;
+    FILE* Out = fopen(Path.c_str(), "wb");
+    if (Out == nullptr) continue;
+
+    if (fwrite(Entry.second.data(), 1, Entry.second.size(), Out) == Entry.second.size()) Written++;
+    fclose(Out);
+  }
+  return Written;
+}
+
+/* Load cell */
+
+static float ZeroForce(uint64_t Time, uint8_t Cell, void* Context)
+{
+  (void) Time;
+  (void) Cell;
+  (void) Context;
+  return 0.0f;
+}
+
+static HalSimForceSource ForceSource = ZeroForce;
+static void* ForceContext = nullptr;
+static bool LoadCellActive = false;
+static bool LoadCellReady = false;
+static float LoadCellScale;   // Counts per N
+static uint8_t LoadCellCount = 1;
+static uint8_t LoadCellPins[HAL_LOAD_CELLS];
+static float LoadCellRaw[HAL_LOAD_CELLS];
+static float LoadCellData[HAL_LOAD_CELLS];
+static float LoadCellOffset[HAL_LOAD_CELLS];
+static uint64_t NextConversion;
+static uint64_t LoadCellStallStart;
+static uint64_t LoadCellStallEnd;
+
+static uint32_t LoadCellPeriod(void)
+{
+#if GPIO_LOAD_CELL_RATE != 255
+  return 1000000 / (Pins[GPIO_LOAD_CELL_RATE].Level ? 80 : 10);
+#else
+  return 1000000 / HAL_SIM_LOAD_CELL_FIXED_RATE;
+#endif
+}
+
+static void LoadCellConvert(void)
+{
+  // Every reading is latched now, the DOUT lines fall one after the other
+  for (uint8_t c = 0; c < LoadCellCount; c++) LoadCellRaw[c] = ForceSource(Now, c, ForceContext) * LoadCellScale;
+  LoadCellReady = true;
+  for (uint8_t c = 0; c < LoadCellCount; c++) SetPinLevel(LoadCellPins[c], false);
+}
+
+bool HalLoadCellBegin(const uint8_t* DataPins, uint8_t Count, uint32_t SettleTime, float CalibrationFactor)
+{
+  // App scales by 1/100000, keep GetData() in the same counts
+  LoadCellScale = 100000.0f / CalibrationFactor;
+  LoadCellCount = Count < 1 ? 1 : (Count > HAL_LOAD_CELLS ? HAL_LOAD_CELLS : Count);
+  for (uint8_t c = 0; c < LoadCellCount; c++)
+  {
+    LoadCellPins[c] = DataPins[c];
+    Pins[DataPins[c]].Level = true;
+  }
+
+  // Settling and the tare block, just like the real driver
+  Now += uint64_t(SettleTime) * 1000;
+  for (uint8_t c = 0; c < LoadCellCount; c++)
+  {
+    float Sum = 0.0f;
+    for (uint32_t i = 0; i < HAL_SIM_LOAD_CELL_TARE_SAMPLES; i++) Sum += ForceSource(Now, c, ForceContext);
+    LoadCellOffset[c] = Sum / HAL_SIM_LOAD_CELL_TARE_SAMPLES * LoadCellScale;
+  }
+
+  LoadCellActive = true;
+  NextConversion = Now + LoadCellPeriod();
+  return true;
+}
+
+bool HalLoadCellUpdate(void)
+{
+  // The shared clock-out waits for the last DOUT
+  if (!LoadCellReady) return false;
+  for (uint8_t c = 0; c < LoadCellCount; c++)
+  {
+    if (Pins[LoadCellPins[c]].Level) return false;
+  }
+
+  // Clocking the data out releases every DOUT
+  LoadCellReady = false;
+  for (uint8_t c = 0; c < LoadCellCount; c++)
+  {
+    LoadCellData[c] = LoadCellRaw[c] - LoadCellOffset[c];
+    SetPinLevel(LoadCellPins[c], true);
+  }
+  return true;
+}
+
+float HalLoadCellGetData(uint8_t Cell)
+{
+  return LoadCellData[Cell];
+}
+
+void HalLoadCellTare(void)
+{
+  for (uint8_t c = 0; c < LoadCellCount; c++) LoadCellOffset[c] = LoadCellRaw[c];
+}
+
+void HalSimSetLoadCellStall(uint64_t Start, uint64_t Duration)
+{
+  LoadCellStallStart = Start;
+  LoadCellStallEnd = Start + Duration;
+}
+
+void HalSimSetLoadCellSource(HalSimForceSource Source, void* Context)
+{
+  ForceSource = Source ? Source : ZeroForce;
+  ForceContext = Context;
+}
+
+/* Thermistor ADC */
+
+static uint16_t DefaultThermistorCode(void* Context, uint8_t Pin)
+{
+  (void) Context;
+  (void) Pin;
+  return HAL_SIM_THERMISTOR_CODE;
+}
+
+static ThermistorAdcSource ThermistorSource = DefaultThermistorCode;
+static void* ThermistorContext = nullptr;
+static ThermistorAdc* AdcAttached = nullptr;
+static uint64_t NextBlock;
+
+void HalSimSetThermistorSource(ThermistorAdcSource Source, void* Context)
+{
+  ThermistorSource = Source ? Source : DefaultThermistorCode;
+  ThermistorContext = Context;
+}
+
+/* Display */
+
+void HalDisplayBegin(uint32_t BusClock)
+{
+  (void) BusClock;
+}
+
+void HalDisplayClear(void)
+{
+}
+
+void HalDisplaySetFont(E_HAL_FONT Font)
+{
+  (void) Font;
+}
+
+void HalDisplayDrawHLine(uint8_t x, uint8_t y, uint8_t Width)
+{
+  (void) x;
+  (void) y;
+  (void) Width;
+}
+
+void HalDisplayDrawStr(uint8_t x, uint8_t y, const char* Text)
+{
+  (void) x;
+  (void) y;
+  (void) Text;
+}
+
+uint8_t HalDisplayGetTileRows(void)
+{
+  return 8;
+}
+
+void HalDisplaySendTileRow(uint8_t Row)
+{
+  (void) Row;
+}
+
+/* Events */
+
+uint64_t HalSimNextEvent(void)
+{
+  // The ADC starts converting as soon as the engine is begun
+  if (AdcAttached == nullptr && ThermistorAdcSimInstance() != nullptr)
+  {
+    AdcAttached = ThermistorAdcSimInstance();
+    NextBlock = Now + HAL_SIM_ADC_BLOCK_TIME;
+  }
+
+  uint64_t Next = UINT64_MAX;
+  if (LoadCellActive && NextConversion < Next) Next = NextConversion;
+  if (AdcAttached != nullptr && NextBlock < Next) Next = NextBlock;
+  if (NextPinChange() < Next) Next = NextPinChange();
+  return Next;
+}
+
+void HalSimAdvanceTo(uint64_t Time)
+{
+  while (true)
+  {
+    uint64_t Next = HalSimNextEvent();
+    if (Next > Time) break;
+    if (Next > Now) Now = Next;
+
+    if (LoadCellActive && NextConversion <= Now)
+    {
+      if (Now < LoadCellStallStart || Now >= LoadCellStallEnd) LoadCellConvert();
+      NextConversion += LoadCellPeriod();
+    }
+
+    if (AdcAttached != nullptr && NextBlock <= Now)
+    {
+      ThermistorAdcSimulateBlock(*AdcAttached, ThermistorSource, ThermistorContext, Now);
+      NextBlock += HAL_SIM_ADC_BLOCK_TIME;
+    }
+
+    for (SimPinChange& Change : PinChanges)
+    {
+      if (!Change.Pending || Change.Time > Now) continue;
+      Change.Pending = false;
+      SetPinLevel(Change.Pin, Change.Level);
+    }
+  }
+
+  if (Time > Now) Now = Time;
+}
+
+#endif
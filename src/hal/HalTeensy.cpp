@@ -0,0 +1,268 @@
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include <U8g2lib.h>
+
+#include "Config.h"
+#include "Hal.h"
+#include "Hx711Array.h"
+
+/* Console */
+
+class SerialConsole : public HalPrint
+{
+public:
+  size_t Write(const void* Data, size_t Size) override { return Serial.write((const uint8_t*) Data, Size); }
+};
+
+static SerialConsole Console;
+
+void HalConsoleBegin(uint32_t Baud)
+{
+  Serial.begin(Baud);
+}
+
+HalPrint& HalConsole(void)
+{
+  return Console;
+}
+
+size_t HalConsoleWriteAvailable(void)
+{
+  return Serial.availableForWrite();
+}
+
+/* GPIO */
+
+void HalPinMode(uint8_t Pin, E_HAL_PIN_MODE Mode)
+{
+  pinMode(Pin, Mode == HAL_OUTPUT ? OUTPUT : INPUT);
+}
+
+void HalDigitalWrite(uint8_t Pin, bool Level)
+{
+  digitalWrite(Pin, Level ? HIGH : LOW);
+}
+
+bool HalDigitalRead(uint8_t Pin)
+{
+  return digitalRead(Pin) == HIGH;
+}
+
+void HalAttachInterrupt(uint8_t Pin, void (*Isr)(void), E_HAL_INTERRUPT Mode)
+{
+  static const int Modes[] = { RISING, FALLING, HIGH };
+  attachInterrupt(digitalPinToInterrupt(Pin), Isr, Modes[Mode]);
+}
+
+uint32_t HalRandom(uint32_t Max)
+{
+  return uint32_t(random(Max));
+}
+
+/* File system */
+
+static SdFs Sd;
+static File32 Files[HAL_MAX_FILES];
+
+bool HalFsBegin(void)
+{
+  return Sd.begin(SdioConfig(FIFO_SDIO));
+}
+
+bool HalFsExists(const char* Name)
+{
+  return Sd.exists(Name);
+}
+
+bool HalFsRemove(const char* Name)
+{
+  return Sd.remove(Name);
+}
+
+bool HalFile::Open(const char* Name)
+{
+  if (IsOpen()) Close();
+
+  for (int8_t i = 0; i < HAL_MAX_FILES; i++)
+  {
+    if (Files[i].isOpen()) continue;
+    if (!Files[i].open(Name, O_RDWR | O_CREAT | O_TRUNC)) return false;
+
+    Slot = i;
+    return true;
+  }
+  return false;
+}
+
+bool HalFile::Close(void)
+{
+  if (!IsOpen()) return false;
+
+  bool Closed = Files[Slot].close();
+  Slot = -1;
+  return Closed;
+}
+
+size_t HalFile::Write(const void* Data, size_t Size)
+{
+  if (!IsOpen()) return 0;
+  return Files[Slot].write(Data, Size);
+}
+
+bool HalFile::Sync(void)
+{
+  return IsOpen() && Files[Slot].sync();
+}
+
+bool HalFile::SeekSet(uint32_t Position)
+{
+  return IsOpen() && Files[Slot].seekSet(Position);
+}
+
+bool HalFile::Truncate(uint32_t Length)
+{
+  return IsOpen() && Files[Slot].truncate(Length);
+}
+
+bool HalFile::PreAllocate(uint32_t Length)
+{
+  return IsOpen() && Files[Slot].preAllocate(Length);
+}
+
+uint32_t HalFile::GetPosition(void) const
+{
+  return IsOpen() ? Files[Slot].curPosition() : 0;
+}
+
+/* Load cell */
+
+#define HAL_LOAD_CELL_SCK_DELAY         250   // ns, HX711 SCK high and low are 0.2 us minimum
+#define HAL_LOAD_CELL_TARE_TIMEOUT      3000  // ms, 16 conversions at 10 SPS plus margin
+
+static_assert(HAL_LOAD_CELLS == HX711_CELLS, "Hal.h and Hx711Array.h disagree on the cell count");
+
+// DOUT pins on the same GPIO port (pins 6 to 9 all sit on GPIO7) take one register read per pulse
+class Hx711Port
+{
+public:
+  Hx711Levels Read(void) const
+  {
+    uint32_t Port = *DataPort[0];
+    Hx711Levels Levels = 0;
+    for (uint8_t c = 0; c < Count; c++)
+    {
+      if (!SharedPort) Port = *DataPort[c];
+      Levels |= Hx711Levels(((Port & DataMask[c]) != 0) << c);
+    }
+    return Levels;
+  }
+
+  void Clock(bool Level) { digitalWriteFast(GPIO_LOAD_CELL_SCK, Level); }
+  void Wait(void) { delayNanoseconds(HAL_LOAD_CELL_SCK_DELAY); }
+
+  volatile uint32_t* DataPort[HAL_LOAD_CELLS];
+  uint32_t DataMask[HAL_LOAD_CELLS];
+  uint8_t Count = 1;
+  bool SharedPort = true;
+};
+
+static Hx711Array LoadCells;
+static Hx711Port LoadCellPort;
+
+bool HalLoadCellBegin(const uint8_t* DataPins, uint8_t Count, uint32_t SettleTime, float CalibrationFactor)
+{
+  // SCK low powers the HX711s up
+  pinMode(GPIO_LOAD_CELL_SCK, OUTPUT);
+  digitalWriteFast(GPIO_LOAD_CELL_SCK, LOW);
+
+  LoadCells.Begin(Count, CalibrationFactor);
+  LoadCellPort.Count = LoadCells.GetCount();
+  for (uint8_t c = 0; c < LoadCellPort.Count; c++)
+  {
+    pinMode(DataPins[c], INPUT);
+    LoadCellPort.DataPort[c] = portInputRegister(DataPins[c]);
+    LoadCellPort.DataMask[c] = digitalPinToBitMask(DataPins[c]);
+    if (LoadCellPort.DataPort[c] != LoadCellPort.DataPort[0]) LoadCellPort.SharedPort = false;
+  }
+
+  // Keep converting while the filters settle, then zero every cell
+  uint32_t Start = millis();
+  while (millis() - Start < SettleTime) HalLoadCellUpdate();
+
+  LoadCells.Tare();
+  Start = millis();
+  while (LoadCells.IsTaring())
+  {
+    if (millis() - Start > HAL_LOAD_CELL_TARE_TIMEOUT) return false;
+    HalLoadCellUpdate();
+  }
+  return true;
+}
+
+bool HalLoadCellUpdate(void)
+{
+  // About 13 us with interrupts off, a longer SCK high would power the HX711s down
+  uint32_t Primask;
+  __asm__ volatile("mrs %0, primask" : "=r" (Primask));
+  __disable_irq();
+
+  bool Read = LoadCells.Update(LoadCellPort);
+
+  if (!Primask) __enable_irq();
+  return Read;
+}
+
+float HalLoadCellGetData(uint8_t Cell)
+{
+  return LoadCells.GetData(Cell);
+}
+
+void HalLoadCellTare(void)
+{
+  LoadCells.Tare();
+}
+
+/* Display */
+
+// GPIO_DISPLAY_SCL / GPIO_DISPLAY_SDA are the hardware Wire pins
+static U8G2_SSD1306_128X64_NONAME_F_HW_I2C Display(U8G2_R0, U8X8_PIN_NONE);
+
+void HalDisplayBegin(uint32_t BusClock)
+{
+  Display.setBusClock(BusClock);
+  Display.begin();
+}
+
+void HalDisplayClear(void)
+{
+  Display.clearBuffer();
+}
+
+void HalDisplaySetFont(E_HAL_FONT Font)
+{
+  Display.setFont(Font == HAL_FONT_LARGE ? u8g2_font_10x20_me : u8g2_font_3x5im_mr);
+}
+
+void HalDisplayDrawHLine(uint8_t x, uint8_t y, uint8_t Width)
+{
+  Display.drawHLine(x, y, Width);
+}
+
+void HalDisplayDrawStr(uint8_t x, uint8_t y, const char* Text)
+{
+  Display.drawStr(x, y, Text);
+}
+
+uint8_t HalDisplayGetTileRows(void)
+{
+  return Display.getBufferTileHeight();
+}
+
+void HalDisplaySendTileRow(uint8_t Row)
+{
+  Display.updateDisplayArea(0, Row, Display.getBufferTileWidth(), 1);
+}
+
+#endif
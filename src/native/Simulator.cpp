@@ -0,0 +1,678 @@
+#if !defined(ARDUINO)
+
+#include "Simulator.h"
+#include "Clock.h"
+#include "Config.h"
+#include "ForceFilter.h"
+#include "HalSim.h"
+#include "Channels.h"
+#include "LogRecorder.h"
+#include "Telemetry.h"
+#include "Thermistor.h"
+#include "ThermistorAdc.h"
+
+#include <math.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+static const float TableE12[][2] = {
+  { 0.00f, 0.0f }, { 0.05f, 12.0f }, { 0.20f, 32.0f }, { 0.30f, 18.0f }, { 0.50f, 11.0f },
+  { 2.50f, 10.0f }, { 2.80f, 4.0f }, { 3.00f, 0.0f }
+};
+
+const SimScenario SIM_SCENARIOS[] = {
+  // Name              Seed  Curve                   Peak    Delay  Burn   Table     Size Noise  Temperature     Rate           TNoise LC stall      SD us  SD stall     No PSRAM USB B/s
+  { "nominal",         1,    SIM_CURVE_HALF_SINE,    100.0f, 0.3f,  2.0f,  nullptr,  0,   0.2f,  { 20.0f, 20.0f }, { 0.0f, 0.0f }, 0.1f, 0.0f, 0.0f,   0,     0.0f, 0.0f, false,   0 },
+  { "misfire",         2,    SIM_CURVE_NONE,         0.0f,   0.0f,  0.0f,  nullptr,  0,   0.2f,  { 20.0f, 20.0f }, { 0.0f, 0.0f }, 0.1f, 0.0f, 0.0f,   0,     0.0f, 0.0f, false,   0 },
+  { "progressive",     3,    SIM_CURVE_PROGRESSIVE,  400.0f, 0.2f,  1.2f,  nullptr,  0,   0.5f,  { 20.0f, 20.0f }, { 0.0f, 0.0f }, 0.1f, 0.0f, 0.0f,   0,     0.0f, 0.0f, false,   0 },
+  { "regressive",      4,    SIM_CURVE_REGRESSIVE,   60.0f,  0.2f,  2.5f,  nullptr,  0,   0.2f,  { 20.0f, 20.0f }, { 0.0f, 0.0f }, 0.1f, 0.0f, 0.0f,   0,     0.0f, 0.0f, false,   0 },
+  { "table-e12",       5,    SIM_CURVE_TABLE,        0.0f,   0.1f,  0.0f,  TableE12, 8,   0.2f,  { 20.0f, 20.0f }, { 0.0f, 0.0f }, 0.1f, 0.0f, 0.0f,   0,     0.0f, 0.0f, false,   0 },
+  { "noisy",           6,    SIM_CURVE_HALF_SINE,    100.0f, 0.3f,  2.0f,  nullptr,  0,   2.0f,  { 20.0f, 20.0f }, { 0.0f, 0.0f }, 1.0f, 0.0f, 0.0f,   0,     0.0f, 0.0f, false,   0 },
+  { "long-burn",       7,    SIM_CURVE_HALF_SINE,    30.0f,  0.3f,  8.0f,  nullptr,  0,   0.2f,  { 20.0f, 20.0f }, { 0.0f, 0.0f }, 0.1f, 0.0f, 0.0f,   0,     0.0f, 0.0f, false,   0 },
+  { "late-ignition",   8,    SIM_CURVE_HALF_SINE,    100.0f, 3.0f,  2.0f,  nullptr,  0,   0.2f,  { 20.0f, 20.0f }, { 0.0f, 0.0f }, 0.1f, 0.0f, 0.0f,   0,     0.0f, 0.0f, false,   0 },
+  { "hot-motor",       9,    SIM_CURVE_HALF_SINE,    100.0f, 0.3f,  2.0f,  nullptr,  0,   0.2f,  { 20.0f, 22.0f }, { 30.0f, 1.0f }, 0.5f, 0.0f, 0.0f,  0,     0.0f, 0.0f, false,   0 },
+  { "hx711-stall",     10,   SIM_CURVE_HALF_SINE,    100.0f, 0.3f,  2.0f,  nullptr,  0,   0.2f,  { 20.0f, 20.0f }, { 0.0f, 0.0f }, 0.1f, 1.2f, 0.25f,  0,     0.0f, 0.0f, false,   0 },
+  { "sd-slow",         11,   SIM_CURVE_HALF_SINE,    100.0f, 0.3f,  2.0f,  nullptr,  0,   0.2f,  { 20.0f, 20.0f }, { 0.0f, 0.0f }, 0.1f, 0.0f, 0.0f,   2000,  0.0f, 0.0f, false,   0 },
+  { "sd-stall",        12,   SIM_CURVE_HALF_SINE,    100.0f, 0.3f,  2.0f,  nullptr,  0,   0.2f,  { 20.0f, 20.0f }, { 0.0f, 0.0f }, 0.1f, 0.0f, 0.0f,   200,   2.0f, 5.0f, false,   0 },
+  { "sd-stall-sram",   14,   SIM_CURVE_HALF_SINE,    100.0f, 0.3f,  2.0f,  nullptr,  0,   0.2f,  { 20.0f, 20.0f }, { 0.0f, 0.0f }, 0.1f, 0.0f, 0.0f,   200,   0.8f, 0.7f, true,    0 },
+  { "usb-slow",        13,   SIM_CURVE_HALF_SINE,    100.0f, 0.3f,  2.0f,  nullptr,  0,   0.2f,  { 20.0f, 20.0f }, { 0.0f, 0.0f }, 0.1f, 0.0f, 0.0f,   0,     0.0f, 0.0f, false,   2000 },
+};
+
+const uint32_t SIM_SCENARIO_COUNT = sizeof(SIM_SCENARIOS) / sizeof(SIM_SCENARIOS[0]);
+
+/* Script */
+
+static const SimScenario* Script;
+static uint64_t RelayTime;    // us, 0 until the relay command
+static uint64_t LastRecordTime;
+static uint32_t NoiseState;
+static std::vector<uint8_t> ConsoleStream;
+static const ThermistorTable ThermistorTables[2] = {
+  ThermistorTable(THERMISTOR_1_RESISTANCE, THERMISTOR_CALIBRATION_OFFSET),
+  ThermistorTable(THERMISTOR_2_RESISTANCE, THERMISTOR_CALIBRATION_OFFSET)
+};
+
+static uint32_t NextRandom(uint32_t& State)
+{
+  // xorshift32
+  State ^= State << 13;
+  State ^= State >> 17;
+  State ^= State << 5;
+  return State;
+}
+
+static double Gaussian(void)
+{
+  double u1 = (NextRandom(NoiseState) + 1.0) / 4294967297.0;
+  double u2 = (NextRandom(NoiseState) + 1.0) / 4294967297.0;
+  return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static double ThrustEnd(const SimScenario& Scenario)
+{
+  switch (Scenario.Curve)
+  {
+  case SIM_CURVE_NONE:
+    return 0.0;
+
+  case SIM_CURVE_TABLE:
+    return Scenario.IgnitionDelay + Scenario.Table[Scenario.TableSize - 1][0];
+
+  default:
+    return Scenario.IgnitionDelay + Scenario.BurnTime;
+  }
+}
+
+// Noise free thrust t s after ignition
+static double CurveThrust(const SimScenario& Scenario, double t)
+{
+  double Peak = Scenario.PeakThrust;
+  double Burn = Scenario.BurnTime;
+  if (t < 0.0) return 0.0;
+
+  switch (Scenario.Curve)
+  {
+  case SIM_CURVE_HALF_SINE:
+    return t < Burn ? Peak * sin(M_PI * t / Burn) : 0.0;
+
+  case SIM_CURVE_PROGRESSIVE:
+    return t < Burn ? Peak * t / Burn : 0.0;
+
+  case SIM_CURVE_REGRESSIVE:
+    return t < Burn ? Peak * (1.0 - t / Burn) : 0.0;
+
+  case SIM_CURVE_TABLE:
+    for (uint8_t i = 1; i < Scenario.TableSize; i++)
+    {
+      const float* a = Scenario.Table[i - 1];
+      const float* b = Scenario.Table[i];
+      if (t < a[0] || t >= b[0]) continue;
+      return a[1] + (b[1] - a[1]) * (t - a[0]) / (b[0] - a[0]);
+    }
+    return 0.0;
+
+  default:
+    return 0.0;
+  }
+}
+
+static double ScriptedPeak(const SimScenario& Scenario)
+{
+  if (Scenario.Curve != SIM_CURVE_TABLE) return Scenario.PeakThrust;
+
+  double Peak = 0.0;
+  for (uint8_t i = 0; i < Scenario.TableSize; i++) Peak = fmax(Peak, Scenario.Table[i][1]);
+  return Peak;
+}
+
+// s from the relay command until the thrust last reaches the burnout threshold
+static double ScriptedBurnout(const SimScenario& Scenario)
+{
+  double End = ThrustEnd(Scenario);
+  for (double t = End; t > Scenario.IgnitionDelay; t -= 0.001)
+  {
+    if (CurveThrust(Scenario, t - Scenario.IgnitionDelay) >= BURNOUT_THRESHOLD) return t;
+  }
+  return End;
+}
+
+static double ExpectedImpulse(const SimScenario& Scenario)
+{
+  switch (Scenario.Curve)
+  {
+  case SIM_CURVE_HALF_SINE:
+    return 2.0 / M_PI * Scenario.PeakThrust * Scenario.BurnTime;
+
+  case SIM_CURVE_PROGRESSIVE:
+  case SIM_CURVE_REGRESSIVE:
+    return 0.5 * Scenario.PeakThrust * Scenario.BurnTime;
+
+  case SIM_CURVE_TABLE:
+  {
+    double Impulse = 0.0;
+    for (uint8_t i = 1; i < Scenario.TableSize; i++)
+    {
+      Impulse += 0.5 * (Scenario.Table[i][1] + Scenario.Table[i - 1][1]) * (Scenario.Table[i][0] - Scenario.Table[i - 1][0]);
+    }
+    return Impulse;
+  }
+
+  default:
+    return 0.0;
+  }
+}
+
+// The thrust spreads evenly over the cells, each adds its share of the noise
+static float ScriptForce(uint64_t Time, uint8_t Cell, void* Context)
+{
+  (void) Cell;
+  (void) Context;
+
+  double Force = Script->ForceNoise * Gaussian() / sqrt(double(LOAD_CELL_COUNT));
+  if (RelayTime != 0 && Script->Curve != SIM_CURVE_NONE)
+  {
+    Force += CurveThrust(*Script, (Time - RelayTime) * 1e-6 - Script->IgnitionDelay) / LOAD_CELL_COUNT;
+  }
+  return float(Force);
+}
+
+// Sum of the per-cell channels in ReadLoadCells() order, the total with a single cell
+static float CellSum(const LogRecord& Record)
+{
+  const uint8_t Cells[] = { SensorChannels::IndexOf<LoadCellChannel<0>>(), SensorChannels::IndexOf<LoadCellChannel<1>>(),
+    SensorChannels::IndexOf<LoadCellChannel<2>>(), SensorChannels::IndexOf<LoadCellChannel<3>>() };
+  if (Cells[0] == SensorChannels::COUNT) return SensorChannels::Get<ForceChannel>(Record);
+
+  float Sum = 0.0f;
+  for (uint8_t Index : Cells)
+  {
+    if (Index < SensorChannels::COUNT) Sum += SensorChannels::GetFloat(Record, Index);
+  }
+  return Sum;
+}
+
+// Raw code whose firmware conversion is closest to Temperature
+static uint16_t TemperatureCode(const ThermistorTable& Table, double Temperature)
+{
+  uint16_t Low = 1;
+  uint16_t High = (1u << THERMISTOR_ADC_RESOLUTION) - 1;
+  while (Low < High)
+  {
+    uint16_t Middle = (Low + High) / 2;
+    if (Table.Convert(Middle, THERMISTOR_ADC_RESOLUTION) < Temperature) Low = Middle + 1;
+    else High = Middle;
+  }
+  return Low;
+}
+
+static uint16_t ScriptThermistor(void* Context, uint8_t Pin)
+{
+  (void) Context;
+
+  // A block is converted all at once, so one code per channel and block is enough
+  static uint64_t CachedTime[2] = { UINT64_MAX, UINT64_MAX };
+  static uint16_t CachedCode[2];
+
+  // Other analog channels sit at their zero
+  if (Pin == GPIO_PRESSURE_1) return uint16_t(PRESSURE_1_ZERO_VOLTAGE / THERMISTOR_SUPPLY_VOLTAGE * (1u << THERMISTOR_ADC_RESOLUTION) + 0.5);
+
+  uint8_t Channel = Pin == GPIO_THERMISTOR_1 ? 0 : 1;
+  uint64_t Now = ClockMicros();
+  if (CachedTime[Channel] != Now)
+  {
+    double Heating = RelayTime != 0 ? (Now - RelayTime) * 1e-6 * Script->TemperatureRate[Channel] : 0.0;
+    double Temperature = Script->Temperature[Channel] + Heating + Script->TemperatureNoise * Gaussian();
+    CachedCode[Channel] = TemperatureCode(ThermistorTables[Channel], Temperature);
+    CachedTime[Channel] = Now;
+  }
+  return CachedCode[Channel];
+}
+
+/* Scenarios */
+
+SimScenario SimRandomScenario(uint32_t Index, uint32_t Seed, char* Name, uint32_t NameSize)
+{
+  uint32_t State = (Seed * 2654435761u) ^ (Index + 1) * 40503u;
+  if (State == 0) State = 1;
+  auto Uniform = [&State](float Min, float Max) { return Min + (Max - Min) * float(NextRandom(State) >> 8) / 16777216.0f; };
+
+  snprintf(Name, NameSize, "sweep-%lu", (unsigned long) Index);
+
+  SimScenario Scenario = SIM_SCENARIOS[0];
+  Scenario.Name = Name;
+  Scenario.Seed = NextRandom(State);
+  Scenario.Curve = E_SIM_CURVE(SIM_CURVE_NONE + NextRandom(State) % SIM_CURVE_TABLE);
+  Scenario.PeakThrust = Uniform(20.0f, 500.0f);
+  Scenario.IgnitionDelay = Uniform(0.0f, 2.0f);
+  Scenario.BurnTime = Uniform(0.5f, 6.0f);
+  Scenario.ForceNoise = Uniform(0.0f, 1.0f);
+  Scenario.Temperature[0] = Uniform(-10.0f, 40.0f);
+  Scenario.Temperature[1] = Scenario.Temperature[0];
+  Scenario.TemperatureRate[0] = Uniform(0.0f, 20.0f);
+
+  if (NextRandom(State) % 4 == 0)
+  {
+    Scenario.LoadCellStallStart = Uniform(0.0f, 8.0f);
+    Scenario.LoadCellStallDuration = Uniform(0.01f, 0.5f);
+  }
+  if (NextRandom(State) % 4 == 0)
+  {
+    Scenario.SdBlockTime = uint32_t(Uniform(50.0f, 3000.0f));
+    Scenario.SdStallStart = Uniform(0.0f, 10.0f);
+    Scenario.SdStallDuration = Uniform(0.0f, 2.0f);
+  }
+  if (NextRandom(State) % 4 == 0)
+  {
+    Scenario.UsbRate = uint32_t(Uniform(500.0f, 20000.0f));
+  }
+  return Scenario;
+}
+
+/* Run */
+
+static void CaptureConsole(const void* Data, size_t Size, void* Context)
+{
+  const SimOptions* Options = (const SimOptions*) Context;
+  const uint8_t* Bytes = (const uint8_t*) Data;
+  ConsoleStream.insert(ConsoleStream.end(), Bytes, Bytes + Size);
+
+  // Blocks while a receiver on a pty falls behind, which only costs wall time
+  while (Options->TelemetryFd >= 0 && Size != 0)
+  {
+    ssize_t Written = write(Options->TelemetryFd, Bytes, Size);
+    if (Written <= 0) break;
+    Bytes += Written;
+    Size -= Written;
+  }
+}
+
+static const uint8_t* FindLog(uint32_t* Size)
+{
+  // Same names CreateLogFile() picks from
+  for (uint32_t i = 0; i < 100; i++)
+  {
+    char Name[32];
+    snprintf(Name, sizeof(Name), "Motor Test Data #%lu.bin", (unsigned long) i);
+    const uint8_t* Data = HalSimReadFile(Name, Size);
+    if (Data != nullptr) return Data;
+  }
+  return nullptr;
+}
+
+static bool ReadTrailer(const uint8_t* Data, uint32_t Size, LogFileTrailer& Trailer)
+{
+  if (Size < LOG_HEADER_SIZE + sizeof(LogFileTrailer)) return false;
+  memcpy(&Trailer, Data + Size - sizeof(Trailer), sizeof(Trailer));
+  return Trailer.Magic == LOG_TRAILER_MAGIC;
+}
+
+static void Fail(SimReport& Report, const char* Failure)
+{
+  if (!Report.Passed) return;
+
+  Report.Passed = false;
+  snprintf(Report.Failure, sizeof(Report.Failure), "%s", Failure);
+}
+
+static void CheckLog(const SimScenario& Scenario, SimReport& Report, uint64_t ButtonTime)
+{
+  uint32_t Size = 0;
+  const uint8_t* Data = FindLog(&Size);
+  if (Data == nullptr) return Fail(Report, "no log file");
+
+  LogFileHeader Header;
+  if (Size < LOG_HEADER_SIZE) return Fail(Report, "log shorter than its header");
+  memcpy(&Header, Data, sizeof(Header));
+  if (Header.Magic != LOG_FILE_MAGIC || Header.Version != LOG_FILE_VERSION || Header.RecordSize != sizeof(LogRecord)
+      || Header.TrailerSize != sizeof(LogFileTrailer) || Header.ChannelCount != SensorChannels::COUNT
+      || Header.FilterType != (FORCE_FILTER ? FORCE_FILTER_TYPE : FORCE_FILTER_NONE))
+  {
+    return Fail(Report, "bad log header");
+  }
+  if (memcmp(Data + sizeof(Header), SensorChannels::INFO, sizeof(SensorChannels::INFO)) != 0) return Fail(Report, "bad channel table");
+
+  Report.LogBytes = Size;
+  if (!ReadTrailer(Data, Size, Report.Trailer)) return Fail(Report, "no log trailer");
+  Size -= sizeof(LogFileTrailer);
+  if ((Size - LOG_HEADER_SIZE) % sizeof(LogRecord) != 0) Fail(Report, "partial record");
+  Report.Records = (Size - LOG_HEADER_SIZE) / sizeof(LogRecord);
+  if (Report.Records == 0) return Fail(Report, "empty log");
+
+  LogRecord Previous;
+  memcpy(&Previous, Data + LOG_HEADER_SIZE, sizeof(Previous));
+  double FilteredImpulse = 0.0;
+  for (uint32_t i = 1; i < Report.Records; i++)
+  {
+    LogRecord Record;
+    memcpy(&Record, Data + LOG_HEADER_SIZE + i * sizeof(Record), sizeof(Record));
+    if (Record.Time <= Previous.Time) return Fail(Report, "record time not increasing");
+
+    double Gap = (Record.Time - Previous.Time) * 1e-6;
+    if (Gap > Report.MaxGap) Report.MaxGap = Gap;
+
+    float Force = SensorChannels::Get<ForceChannel>(Record);
+    if (CellSum(Record) != Force) return Fail(Report, "load cells do not add up");
+    if (Previous.Time >= RelayTime && RelayTime != 0)
+    {
+      Report.Impulse += 0.5 * (double(Force) + SensorChannels::Get<ForceChannel>(Previous)) * Gap;
+#if FORCE_FILTER
+      FilteredImpulse += 0.5 * (double(SensorChannels::Get<FilteredForceChannel>(Record))
+        + SensorChannels::Get<FilteredForceChannel>(Previous)) * Gap;
+#endif
+    }
+    if (Force > Report.PeakThrust) Report.PeakThrust = Force;
+    Previous = Record;
+  }
+
+  if (RelayTime == 0) return Fail(Report, "relay never fired");
+  double Relay = RelayTime * 1e-6;
+  LastRecordTime = Previous.Time;
+  double LastRecord = Previous.Time * 1e-6;
+  Report.CountdownError = Relay - ButtonTime * 1e-6 - TEST_COUNTDOWN_SECONDS;
+  Report.EndAfterBurnout = LastRecord - (Relay + ScriptedBurnout(Scenario));
+
+  // DetectCountdownEnd()
+  if (fabs(Report.CountdownError) > SIM_COUNTDOWN_TOLERANCE) Fail(Report, "countdown length");
+
+  // DetectTestEnd(): hold-off after burnout, or the duration cap
+  double ExpectedEnd = Scenario.Curve == SIM_CURVE_NONE ? TEST_DURATION_SECONDS
+    : fmin(ScriptedBurnout(Scenario) + BURNOUT_HOLDOFF_SECONDS, double(TEST_DURATION_SECONDS));
+  // Burnout is only seen once samples flow again after a stall
+  double Stalls = Scenario.LoadCellStallDuration + Scenario.SdStallDuration;
+  if (LastRecord - Relay > ExpectedEnd + SIM_BURNOUT_TOLERANCE + Stalls) Fail(Report, "test ended late");
+  if (LastRecord - Relay < ExpectedEnd - SIM_BURNOUT_TOLERANCE - 0.1) Fail(Report, "test ended early");
+
+  // Logging: the impulse survives decimation, burst mode and stalls. On top of the relative
+  // tolerance come the integrated noise, the tare error and the chord across a stall.
+  double Window = LastRecord - Relay;
+  double Tolerance = SIM_IMPULSE_TOLERANCE * Report.ExpectedImpulse + 0.5
+    + 3.0 * Scenario.ForceNoise * sqrt(Window / TEST_DATA_SAMPLE_RATE)
+    + 3.0 * Scenario.ForceNoise / sqrt(double(HAL_SIM_LOAD_CELL_TARE_SAMPLES)) * Window
+    + 0.5 * ScriptedPeak(Scenario) * Scenario.LoadCellStallDuration;
+  if (fabs(Report.Impulse - Report.ExpectedImpulse) > Tolerance) Fail(Report, "impulse mismatch");
+  // Unity gain at DC, the filter only moves the impulse by its delay
+  if (FORCE_FILTER && fabs(FilteredImpulse - Report.Impulse) > Tolerance) Fail(Report, "filtered impulse mismatch");
+
+  double GapLimit = 2.0 / TEST_DATA_SAMPLE_RATE + Scenario.LoadCellStallDuration;
+  if (Report.MaxGap > GapLimit) Fail(Report, "gap in the log");
+
+  // Pipeline accounting: only an SD stall in the log path may cost the log queue samples,
+  // and the ISR queue rides out every scripted stall
+  const LogConsumerStats& Log = Report.Trailer.Consumers[LOG_CONSUMER_LOG];
+  Report.LogQueueLost = Log.Dropped + Log.Decimated;
+  if (Report.Trailer.AcquisitionDropped != 0 || Report.Trailer.RecorderDropped != 0) Fail(Report, "acquisition dropped samples");
+  if (Report.LogQueueLost != 0 && !(Scenario.NoPsram && Scenario.SdStallDuration > 0)) Fail(Report, "log queue dropped samples");
+  if (Log.Pushed < Log.Dropped + Log.Decimated) Fail(Report, "log queue count");
+}
+
+static bool IsText(const uint8_t* Data, size_t Size)
+{
+  for (size_t i = 0; i < Size; i++)
+  {
+    if ((Data[i] < 0x20 || Data[i] > 0x7E) && Data[i] != '\n' && Data[i] != '\r' && Data[i] != '\t') return false;
+  }
+  return true;
+}
+
+// Same rules as tools/telemetry_receiver.py: chunks between zero bytes are frames,
+// or console text when they do not decode
+static void CheckTelemetry(const SimScenario& Scenario, SimReport& Report, bool Verbose)
+{
+  const uint32_t SampleSize = SensorChannels::DATA_SIZE + 1;
+  const uint32_t Overhead = sizeof(TelemetryHeader) + sizeof(uint32_t);
+  std::vector<uint64_t> Times;
+  uint32_t NextSequence = 0;
+  uint32_t TestDropped = 0;
+  uint32_t Layouts = 0;
+
+  size_t Start = 0;
+  for (size_t i = 0; i <= ConsoleStream.size(); i++)
+  {
+    if (i < ConsoleStream.size() && ConsoleStream[i] != 0) continue;
+
+    const uint8_t* Chunk = ConsoleStream.data() + Start;
+    size_t Size = i - Start;
+    Start = i + 1;
+    if (Size == 0) continue;
+
+    uint8_t Raw[TELEMETRY_MAX_FRAME];
+    int32_t Length = Size <= sizeof(Raw) ? CobsDecode(Chunk, Size, Raw) : -1;
+    uint32_t Crc = 0;
+    if (Length >= int32_t(Overhead)) memcpy(&Crc, Raw + Length - sizeof(Crc), sizeof(Crc));
+    if (Length < int32_t(Overhead) || Crc != TelemetryCrc32(Raw, Length - sizeof(Crc)))
+    {
+      if (!IsText(Chunk, Size)) return Fail(Report, "corrupt telemetry frame");
+      if (Verbose) fwrite(Chunk, 1, Size, stdout);
+      continue;
+    }
+
+    TelemetryHeader Header;
+    memcpy(&Header, Raw, sizeof(Header));
+    uint32_t Payload = Length - Overhead;
+    if (Header.Sequence < NextSequence) return Fail(Report, "telemetry sequence went back");
+
+    Report.TelemetryDropped += Header.Sequence - NextSequence;
+    if (Header.Time <= LastRecordTime) TestDropped += Header.Sequence - NextSequence;
+    Report.TelemetryFrames++;
+    NextSequence = Header.Sequence + 1;
+
+    if (Header.Type == TELEMETRY_CHANNEL)
+    {
+      TelemetryChannel Channel;
+      if (Payload != sizeof(Channel)) return Fail(Report, "bad telemetry layout frame");
+      memcpy(&Channel, Raw + sizeof(Header), sizeof(Channel));
+      if (Channel.Count != SensorChannels::COUNT || Channel.Index >= Channel.Count
+          || memcmp(&Channel.Info, &SensorChannels::INFO[Channel.Index], sizeof(ChannelInfo)) != 0)
+      {
+        return Fail(Report, "bad telemetry layout frame");
+      }
+      Layouts++;
+      continue;
+    }
+
+    if (Header.Type != TELEMETRY_SAMPLE) return Fail(Report, "unknown telemetry frame");
+    if (Payload != SampleSize) return Fail(Report, "bad telemetry sample size");
+    if (!Times.empty() && Header.Time <= Times.back()) return Fail(Report, "telemetry time not increasing");
+    Times.push_back(Header.Time);
+  }
+
+  if (Times.empty()) return Fail(Report, "no telemetry");
+  if (Layouts < SensorChannels::COUNT) return Fail(Report, "no telemetry layout");
+  if (Report.TelemetryDropped != 0)
+  {
+    // A slow host may lose frames, a fast one only while the log write blocks the loop
+    bool Blocked = Scenario.NoPsram && Scenario.SdStallDuration > 0;
+    if (Scenario.UsbRate == 0 && !Blocked && TestDropped != 0) Fail(Report, "telemetry frames dropped");
+    return;
+  }
+
+  // With a fast host and no drops every logged sample was streamed as well. A slow one
+  // may still hold the last ones when the run ends.
+  if (Scenario.UsbRate != 0) return;
+  uint32_t Size = 0;
+  const uint8_t* Data = FindLog(&Size);
+  if (Data == nullptr || !ReadTrailer(Data, Size, Report.Trailer)) return;
+  Size -= sizeof(LogFileTrailer);
+
+  size_t Next = 0;
+  for (uint32_t Offset = LOG_HEADER_SIZE; Offset + sizeof(LogRecord) <= Size; Offset += sizeof(LogRecord))
+  {
+    LogRecord Record;
+    memcpy(&Record, Data + Offset, sizeof(Record));
+    while (Next < Times.size() && Times[Next] < Record.Time) Next++;
+    if (Next == Times.size() || Times[Next] != Record.Time) return Fail(Report, "logged sample missing from telemetry");
+  }
+}
+
+// Up to the end of the test, writing out the capture in POST_TEST is allowed to be late
+static void CollectSchedulerStats(SimReport& Report)
+{
+  const Scheduler& Tasks = AppGetTasks();
+  for (uint8_t i = 0; i < Tasks.GetTaskCount(); i++)
+  {
+    const SchedulerTask& Task = Tasks.GetTask(i);
+    Report.DeadlineMisses += Task.DeadlineMisses;
+    Report.SkippedReleases += Task.SkippedReleases;
+    if (Task.MaxLateness >= Report.MaxLateness)
+    {
+      Report.MaxLateness = Task.MaxLateness;
+      Report.WorstTask = Task.Name;
+    }
+  }
+}
+
+void SimRun(const SimScenario& Scenario, SimReport& Report, const SimOptions& Options)
+{
+  Report = SimReport{};
+  Report.Passed = true;
+  Report.ExpectedImpulse = ExpectedImpulse(Scenario);
+  Report.WorstTask = "-";
+
+  Script = &Scenario;
+  RelayTime = 0;
+  NoiseState = (Scenario.Seed * 2654435761u) | 1;
+
+  auto WallStart = std::chrono::steady_clock::now();
+  ConsoleStream.reserve(1u << 20);
+  HalSimSetConsoleSink(CaptureConsole, (void*) &Options);
+  HalSimSetConsoleRate(Scenario.UsbRate);
+  HalSimSetPsram(!Scenario.NoPsram);
+  HalSimSetLoadCellSource(ScriptForce, nullptr);
+  HalSimSetThermistorSource(ScriptThermistor, nullptr);
+  HalSimSetFileTiming(Scenario.SdBlockTime, UINT64_MAX, 0);
+
+  AppSetup();
+  uint64_t SetupAllocations = HalSimAllocations();
+
+  // The press bounces once, only the first edge may start the countdown
+  const uint64_t ButtonTime = uint64_t(SIM_BUTTON_PRESS_TIME * 1e6);
+  HalSimSchedulePin(GPIO_BUTTON_ACTIVATE_TEST, true, ButtonTime);
+  HalSimSchedulePin(GPIO_BUTTON_ACTIVATE_TEST, false, ButtonTime + SIM_BUTTON_BOUNCE_TIME / 2);
+  HalSimSchedulePin(GPIO_BUTTON_ACTIVATE_TEST, true, ButtonTime + SIM_BUTTON_BOUNCE_TIME);
+  HalSimSchedulePin(GPIO_BUTTON_ACTIVATE_TEST, false, ButtonTime + uint64_t(SIM_BUTTON_HOLD_TIME * 1e6));
+
+  const uint64_t TimeLimit = uint64_t(SIM_TIME_LIMIT * 1e6);
+  uint64_t EndTime = TimeLimit;
+  bool Started = false;
+  while (AppGetState() != ERROR && ClockMicros() < EndTime)
+  {
+    // POST_TEST keeps running for a moment so the telemetry backlog reaches the host
+    if (AppGetState() == POST_TEST && EndTime == TimeLimit)
+    {
+      CollectSchedulerStats(Report);
+      EndTime = ClockMicros() + uint64_t(SIM_DRAIN_TIME * 1e6);
+    }
+
+    if (AppLoop())
+    {
+      if (!Started && AppGetState() == COUNTDOWN)
+      {
+        Started = true;
+        Report.StartLatency = uint32_t(ClockMicros() - ButtonTime);
+      }
+
+      // Stalls are scripted relative to the relay command
+      if (RelayTime == 0 && AppGetState() == TEST_ACTIVE)
+      {
+        RelayTime = ClockMicros();
+        HalSimSetLoadCellStall(RelayTime + uint64_t(Scenario.LoadCellStallStart * 1e6),
+          uint64_t(Scenario.LoadCellStallDuration * 1e6));
+        HalSimSetFileTiming(Scenario.SdBlockTime, RelayTime + uint64_t(Scenario.SdStallStart * 1e6),
+          uint64_t(Scenario.SdStallDuration * 1e6));
+      }
+      continue;
+    }
+
+    uint64_t Wakeup = AppNextWakeup();
+    if (HalSimNextEvent() < Wakeup) Wakeup = HalSimNextEvent();
+    if (Wakeup > EndTime) Wakeup = EndTime;
+    if (Options.Realtime) std::this_thread::sleep_until(WallStart + std::chrono::microseconds(Wakeup));
+    HalSimAdvanceTo(Wakeup);
+  }
+
+  Report.State = AppGetState();
+  Report.VirtualTime = ClockMicros() * 1e-6;
+  Report.HeapAllocations = HalSimAllocations() - SetupAllocations;
+
+  if (EndTime == TimeLimit) CollectSchedulerStats(Report);
+
+  if (Report.State != POST_TEST) Fail(Report, Report.State == ERROR ? "ended in ERROR" : "time limit reached");
+  if (Report.HeapAllocations != 0) Fail(Report, "heap allocation after setup");
+  if (Report.StartLatency > SIM_START_LATENCY_LIMIT) Fail(Report, "start command latency");
+  for (uint8_t State = READY_FOR_COUNTDOWN; State <= POST_TEST; State++)
+  {
+    if (AppGetStateEntries(E_OPERATION_STATE(State)) != 1) Fail(Report, "state sequence");
+  }
+  if (AppGetStateEntries(ERROR) != 0) Fail(Report, "state sequence");
+  if (fabs(AppGetStateTime(COUNTDOWN) * 1e-6 - TEST_COUNTDOWN_SECONDS) > SIM_COUNTDOWN_TOLERANCE) Fail(Report, "time in COUNTDOWN");
+  if (Started && Report.StartLatency != AppGetStartLatency()) Fail(Report, "start command latency misreported");
+  CheckLog(Scenario, Report, ButtonTime);
+  CheckTelemetry(Scenario, Report, Options.Verbose);
+
+  Report.WallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - WallStart).count();
+
+  if (Options.OutputDirectory != nullptr)
+  {
+    char Directory[256];
+    snprintf(Directory, sizeof(Directory), "%s/%s", Options.OutputDirectory, Scenario.Name);
+    mkdir(Options.OutputDirectory, 0755);
+    mkdir(Directory, 0755);
+    HalSimDumpFiles(Directory);
+
+    // Raw console stream, tools/telemetry_receiver.py reads it like a port
+    char Path[300];
+    snprintf(Path, sizeof(Path), "%s/telemetry.bin", Directory);
+    FILE* Stream = fopen(Path, "wb");
+    if (Stream != nullptr)
+    {
+      fwrite(ConsoleStream.data(), 1, ConsoleStream.size(), Stream);
+      fclose(Stream);
+    }
+  }
+}
+
+/* Report */
+
+void SimPrintReportHeader(FILE* Out)
+{
+  fprintf(Out, "scenario,result,failure,state,virtual_s,wall_ms,records,log_bytes,max_gap_ms,"
+    "impulse_ns,expected_ns,peak_n,start_latency_us,countdown_error_ms,end_after_burnout_s,telemetry_frames,telemetry_dropped,"
+    "log_queue_lost,log_queue_high_water,log_queue_max_age_us,heap_allocs,"
+    "deadline_misses,skipped_releases,max_lateness_us,worst_task\n");
+}
+
+void SimPrintReport(FILE* Out, const SimScenario& Scenario, const SimReport& Report)
+{
+  fprintf(Out, "%s,%s,%s,%d,%.3f,%.2f,%lu,%lu,%.2f,%.3f,%.3f,%.2f,%lu,%.2f,%.3f,%lu,%lu,%lu,%lu,%lu,%llu,%lu,%lu,%lu,%s\n",
+    Scenario.Name,
+    Report.Passed ? "PASS" : "FAIL",
+    Report.Passed ? "" : Report.Failure,
+    int(Report.State),
+    Report.VirtualTime,
+    Report.WallTime * 1e3,
+    (unsigned long) Report.Records,
+    (unsigned long) Report.LogBytes,
+    Report.MaxGap * 1e3,
+    Report.Impulse,
+    Report.ExpectedImpulse,
+    Report.PeakThrust,
+    (unsigned long) Report.StartLatency,
+    Report.CountdownError * 1e3,
+    Report.EndAfterBurnout,
+    (unsigned long) Report.TelemetryFrames,
+    (unsigned long) Report.TelemetryDropped,
+    (unsigned long) Report.LogQueueLost,
+    (unsigned long) Report.Trailer.Consumers[LOG_CONSUMER_LOG].HighWater,
+    (unsigned long) Report.Trailer.Consumers[LOG_CONSUMER_LOG].MaxAge,
+    (unsigned long long) Report.HeapAllocations,
+    (unsigned long) Report.DeadlineMisses,
+    (unsigned long) Report.SkippedReleases,
+    (unsigned long) Report.MaxLateness,
+    Report.WorstTask);
+}
+
+#endif
@@ -0,0 +1,143 @@
+// The unit tests under test/ bring their own main()
+#if !defined(ARDUINO) && !defined(PIO_UNIT_TESTING)
+
+#include "Simulator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+#include <chrono>
+
+/* Host regression driver
+*
+* Runs scripted scenarios through the whole test sequence in virtual time and
+* prints one CSV report line per scenario. Each scenario runs in a forked child,
+* so every run starts from a freshly booted app.
+*
+* Usage: program [--out DIR] [--verbose] [--sweep COUNT] [--seed N] [--list]
+*                [--pty | --telemetry PATH] [--realtime] [SCENARIO...]
+*
+* Without scenario names all built-in scenarios run, --sweep adds COUNT random ones.
+* The exit code is non-zero when any scenario fails.
+*
+* --pty stands in for the USB serial port: the console stream goes to a new pseudo
+* terminal whose name is printed on stderr, for tools/telemetry_receiver.py to open.
+* --telemetry copies it to an existing file, fifo or tty instead. Once the receiver
+* stops reading the run blocks, and --realtime paces it to the wall clock.
+*/
+
+#define USAGE "Usage: %s [--out DIR] [--verbose] [--sweep COUNT] [--seed N] [--list] " \
+  "[--pty | --telemetry PATH] [--realtime] [SCENARIO...]\n"
+
+static int OpenPty(void)
+{
+  int Master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (Master < 0 || grantpt(Master) != 0 || unlockpt(Master) != 0) return -1;
+
+  // Held open for the whole run so nothing written before the receiver attaches is lost
+  int Slave = open(ptsname(Master), O_RDWR | O_NOCTTY);
+  if (Slave < 0) return -1;
+
+  termios Settings;
+  tcgetattr(Slave, &Settings);
+  cfmakeraw(&Settings);
+  tcsetattr(Slave, TCSANOW, &Settings);
+
+  fprintf(stderr, "telemetry on %s\n", ptsname(Master));
+  return Master;
+}
+
+static bool RunIsolated(const SimScenario& Scenario, const SimOptions& Options)
+{
+  fflush(stdout);
+
+  pid_t Child = fork();
+  if (Child == 0)
+  {
+    SimReport Report;
+    SimRun(Scenario, Report, Options);
+    SimPrintReport(stdout, Scenario, Report);
+    fflush(stdout);
+    _exit(Report.Passed ? 0 : 1);
+  }
+
+  int Status = 0;
+  if (Child < 0 || waitpid(Child, &Status, 0) != Child) return false;
+  if (WIFSIGNALED(Status)) printf("%s,CRASH,signal %d\n", Scenario.Name, WTERMSIG(Status));
+  return WIFEXITED(Status) && WEXITSTATUS(Status) == 0;
+}
+
+int main(int argc, char** argv)
+{
+  SimOptions Options = { nullptr, false, -1, false };
+  bool Pty = false;
+  const char* Telemetry = nullptr;
+  uint32_t Sweep = 0;
+  uint32_t Seed = 1;
+  const char* Selected[64];
+  uint32_t SelectedCount = 0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--out") && i + 1 < argc) Options.OutputDirectory = argv[++i];
+    else if (!strcmp(argv[i], "--verbose")) Options.Verbose = true;
+    else if (!strcmp(argv[i], "--pty")) Pty = true;
+    else if (!strcmp(argv[i], "--telemetry") && i + 1 < argc) Telemetry = argv[++i];
+    else if (!strcmp(argv[i], "--realtime")) Options.Realtime = true;
+    else if (!strcmp(argv[i], "--sweep") && i + 1 < argc) Sweep = strtoul(argv[++i], nullptr, 0);
+    else if (!strcmp(argv[i], "--seed") && i + 1 < argc) Seed = strtoul(argv[++i], nullptr, 0);
+    else if (!strcmp(argv[i], "--list"))
+    {
+      for (uint32_t j = 0; j < SIM_SCENARIO_COUNT; j++) printf("%s\n", SIM_SCENARIOS[j].Name);
+      return 0;
+    }
+    else if (argv[i][0] != '-' && SelectedCount < 64) Selected[SelectedCount++] = argv[i];
+    else
+    {
+      fprintf(stderr, USAGE, argv[0]);
+      return 2;
+    }
+  }
+
+  if (Pty) Options.TelemetryFd = OpenPty();
+  else if (Telemetry != nullptr) Options.TelemetryFd = open(Telemetry, O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, 0644);
+  if ((Pty || Telemetry != nullptr) && Options.TelemetryFd < 0)
+  {
+    perror("telemetry output");
+    return 2;
+  }
+
+  auto WallStart = std::chrono::steady_clock::now();
+  uint32_t Runs = 0;
+  uint32_t Failures = 0;
+  SimPrintReportHeader(stdout);
+
+  for (uint32_t i = 0; i < SIM_SCENARIO_COUNT; i++)
+  {
+    bool Wanted = SelectedCount == 0 && Sweep == 0;
+    for (uint32_t j = 0; j < SelectedCount; j++) Wanted |= !strcmp(Selected[j], SIM_SCENARIOS[i].Name);
+    if (!Wanted) continue;
+
+    Runs++;
+    if (!RunIsolated(SIM_SCENARIOS[i], Options)) Failures++;
+  }
+
+  for (uint32_t i = 0; i < Sweep; i++)
+  {
+    char Name[32];
+    SimScenario Scenario = SimRandomScenario(i, Seed, Name, sizeof(Name));
+
+    Runs++;
+    if (!RunIsolated(Scenario, Options)) Failures++;
+  }
+
+  double Wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - WallStart).count();
+  fprintf(stderr, "%lu scenarios, %lu failed, %.2f s\n", (unsigned long) Runs, (unsigned long) Failures, Wall);
+  return Failures == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Force curves for the host unit tests
+*
+* The CSV files next to this header have the layout of tools/decode_log.py output,
+* time in seconds and force in newtons after a header line. They are found through
+* __FILE__, so the tests do not depend on the working directory.
+*/
+
+#define FIXTURE_MAX_SAMPLES             1024
+
+struct Fixture
+{
+  uint64_t Time[FIXTURE_MAX_SAMPLES];     // us
+  float Force[FIXTURE_MAX_SAMPLES];       // N
+  uint32_t Count;
+};
+
+// False when the file is missing, empty or too long
+static inline bool FixtureLoad(const char* Name, Fixture& Out)
+{
+  char Path[512];
+  const char* Slash = strrchr(__FILE__, '/');
+  int Directory = Slash != nullptr ? int(Slash - __FILE__ + 1) : 0;
+  snprintf(Path, sizeof(Path), "%.*s%s", Directory, __FILE__, Name);
+
+  FILE* File = fopen(Path, "r");
+  if (File == nullptr) return false;
+
+  char Line[128];
+  Out.Count = 0;
+  bool Fits = fgets(Line, sizeof(Line), File) != nullptr;
+  while (Fits && fgets(Line, sizeof(Line), File) != nullptr)
+  {
+    double Seconds;
+    float Force;
+    if (sscanf(Line, "%lf , %f", &Seconds, &Force) != 2) continue;
+    if (Out.Count == FIXTURE_MAX_SAMPLES) Fits = false;
+    else
+    {
+      Out.Time[Out.Count] = uint64_t(llround(Seconds * 1e6));
+      Out.Force[Out.Count] = Force;
+      Out.Count++;
+    }
+  }
+
+  fclose(File);
+  return Fits && Out.Count > 0;
+}
@@ -0,0 +1,158 @@
+#include <unity.h>
+
+#include "BurnoutDetector.h"
+#include "Config.h"
+
+#include "../fixtures/Fixture.h"
+
+#include <math.h>
+
+/* End-of-burn detection with the firmware settings
+*
+* Dips and chuffs shorter than the hold-off must not end a test, a motor that never
+* lights must not either, and the end of a clean burn may only move by the sample
+* spacing when the conversion rate changes.
+*/
+
+#define TIME_CONSTANT                   uint32_t(BURNOUT_FILTER_TIME_CONSTANT * 1e6f)
+#define HOLDOFF                         uint32_t(BURNOUT_HOLDOFF_SECONDS * 1e6f)
+
+static Fixture Curve;
+static BurnoutDetector Detector(TIME_CONSTANT, BURNOUT_ONSET_THRESHOLD, BURNOUT_THRESHOLD, HOLDOFF);
+
+void setUp(void)
+{
+  Detector.Reset();
+}
+
+void tearDown(void) {}
+
+// Time of the sample that confirms burnout, 0 when none did
+static uint64_t RunFixture(const char* Name)
+{
+  TEST_ASSERT_TRUE_MESSAGE(FixtureLoad(Name, Curve), Name);
+  for (uint32_t i = 0; i < Curve.Count; i++)
+  {
+    if (Detector.Update(Curve.Time[i], Curve.Force[i])) return Curve.Time[i];
+  }
+  return 0;
+}
+
+// Force of a 100 N burn from 1 s to 3 s, with an optional dip to DipForce
+static float Burn(uint64_t Time, uint64_t DipStart, uint64_t DipEnd, float DipForce)
+{
+  if (Time < 1000000 || Time >= 3000000) return 0.0f;
+  return Time >= DipStart && Time < DipEnd ? DipForce : 100.0f;
+}
+
+static void test_chuff_does_not_end(void)
+{
+  // Out for 0.2 s at 1 s, the burn ends for good at 1.5 s
+  uint64_t End = RunFixture("chuff.csv");
+  TEST_ASSERT_TRUE(Detector.IsBurnedOut());
+  TEST_ASSERT_GREATER_THAN(1500000, Detector.GetBurnoutTime());
+  TEST_ASSERT_EQUAL_UINT64(Detector.GetBurnoutTime() + HOLDOFF, End);
+}
+
+static void test_dip_does_not_end(void)
+{
+  // Half the hold-off below the burnout threshold in the middle of the burn
+  for (uint64_t Time = 0; Time < 2500000; Time += 12500)
+  {
+    TEST_ASSERT_FALSE(Detector.Update(Time, Burn(Time, 1500000, 1500000 + HOLDOFF / 2, 1.0f)));
+  }
+  TEST_ASSERT_TRUE(Detector.IsIgnited());
+}
+
+static void test_single_sample_drops(void)
+{
+  // Every eighth conversion reads zero, the filtered force stays far above the threshold
+  for (uint64_t Time = 1000000; Time < 3000000; Time += 12500)
+  {
+    TEST_ASSERT_FALSE(Detector.Update(Time, (Time / 12500) % 8 == 0 ? 0.0f : 100.0f));
+    if (Time > 1100000) TEST_ASSERT_GREATER_THAN(BURNOUT_THRESHOLD * 10, Detector.GetFiltered());
+  }
+}
+
+static void test_quiet_restarts_holdoff(void)
+{
+  // A dip right before the real burnout does not count towards the hold-off
+  uint64_t End = 0;
+  for (uint64_t Time = 0; Time < 6000000 && End == 0; Time += 12500)
+  {
+    if (Detector.Update(Time, Burn(Time, 2200000, 2700000, 0.0f))) End = Time;
+  }
+  TEST_ASSERT_GREATER_OR_EQUAL(3000000, Detector.GetBurnoutTime());
+  TEST_ASSERT_GREATER_OR_EQUAL(3000000 + HOLDOFF, End);
+}
+
+static void test_misfire_never_ends(void)
+{
+  // The igniter pops and the grain smoulders below the onset threshold
+  for (uint64_t Time = 0; Time < 20000000; Time += 12500)
+  {
+    float Force = Time >= 1000000 && Time < 1200000 ? BURNOUT_ONSET_THRESHOLD * 0.8f : 0.0f;
+    TEST_ASSERT_FALSE(Detector.Update(Time, Force));
+  }
+  TEST_ASSERT_FALSE(Detector.IsIgnited());
+  TEST_ASSERT_FALSE(Detector.IsBurnedOut());
+}
+
+static void test_sample_rate_independent(void)
+{
+  // Continuous first order decay from 100 N to the threshold after the burn ends at 3 s
+  double Decay = BURNOUT_FILTER_TIME_CONSTANT * log(100.0 / BURNOUT_THRESHOLD);
+  double Expected = 3.0 + Decay + BURNOUT_HOLDOFF_SECONDS;
+
+  const double Rates[] = { 20, 40, 80, 200, 1000, 5000 };
+  for (double Rate : Rates)
+  {
+    Detector.Reset();
+    uint64_t End = 0;
+    for (uint32_t i = 0; End == 0 && i < uint32_t(10 * Rate); i++)
+    {
+      uint64_t Time = uint64_t(i * 1e6 / Rate + 0.5);
+      if (Detector.Update(Time, Burn(Time, 0, 0, 0.0f))) End = Time;
+    }
+
+    // Late by at most two samples, never early
+    char Message[32];
+    snprintf(Message, sizeof(Message), "%g Hz", Rate);
+    TEST_ASSERT_TRUE_MESSAGE(End > 0, Message);
+    TEST_ASSERT_TRUE_MESSAGE(End * 1e-6 >= Expected, Message);
+    TEST_ASSERT_DOUBLE_WITHIN_MESSAGE(2.0 / Rate + 0.001, Expected, End * 1e-6, Message);
+  }
+}
+
+static void test_jittered_spacing(void)
+{
+  // 7 and 13 ms apart, ends within two of the longer gaps of the 10 ms result
+  uint64_t Regular = 0;
+  for (uint64_t Time = 0; Regular == 0 && Time < 10000000; Time += 10000)
+  {
+    if (Detector.Update(Time, Burn(Time, 0, 0, 0.0f))) Regular = Time;
+  }
+
+  Detector.Reset();
+  uint64_t Jittered = 0;
+  for (uint64_t Time = 0, i = 0; Jittered == 0 && Time < 10000000; Time += i++ % 2 ? 13000 : 7000)
+  {
+    if (Detector.Update(Time, Burn(Time, 0, 0, 0.0f))) Jittered = Time;
+  }
+
+  TEST_ASSERT_TRUE(Regular > 0 && Jittered > 0);
+  TEST_ASSERT_INT_WITHIN(26000, Regular, Jittered);
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_chuff_does_not_end);
+  RUN_TEST(test_dip_does_not_end);
+  RUN_TEST(test_single_sample_drops);
+  RUN_TEST(test_quiet_restarts_holdoff);
+  RUN_TEST(test_misfire_never_ends);
+  RUN_TEST(test_sample_rate_independent);
+  RUN_TEST(test_jittered_spacing);
+  return UNITY_END();
+}
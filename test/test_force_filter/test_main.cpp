@@ -0,0 +1,95 @@
+#include <unity.h>
+
+#include "ForceFilter.h"
+
+#include <math.h>
+
+/* Force filter edge cases
+*
+* A NaN or inf sample must not reach the biquad state or the median's sorted window,
+* and a design at the slow HX711 rate must stay below Nyquist.
+*/
+
+static ForceFilter Filter;
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Settles on a constant with one non-finite sample in the middle of it
+static void RunWithGlitch(E_FORCE_FILTER Type, uint8_t Length, float Glitch)
+{
+  Filter.Begin(Type, 80.0f, 10.0f, Length);
+
+  float Block[FORCE_FILTER_BLOCK_SIZE];
+  for (uint32_t n = 0; n < 8; n++)
+  {
+    for (uint32_t i = 0; i < FORCE_FILTER_BLOCK_SIZE; i++) Block[i] = 100.0f;
+    if (n == 2) Block[5] = Glitch;
+    Filter.Process(Block, Block, FORCE_FILTER_BLOCK_SIZE);
+    for (uint32_t i = 0; i < FORCE_FILTER_BLOCK_SIZE; i++)
+    {
+      TEST_ASSERT_TRUE(isfinite(Block[i]));
+    }
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 100.0f, Block[FORCE_FILTER_BLOCK_SIZE - 1]);
+}
+
+void test_nan_biquad(void)
+{
+  RunWithGlitch(FORCE_FILTER_BIQUAD, 1, NAN);
+  RunWithGlitch(FORCE_FILTER_BIQUAD, 1, INFINITY);
+}
+
+void test_nan_fir(void)
+{
+  RunWithGlitch(FORCE_FILTER_FIR, 15, NAN);
+  RunWithGlitch(FORCE_FILTER_FIR, 15, -INFINITY);
+}
+
+void test_nan_median(void)
+{
+  RunWithGlitch(FORCE_FILTER_MEDIAN, 5, NAN);
+  RunWithGlitch(FORCE_FILTER_MEDIAN, 5, INFINITY);
+}
+
+// A step through the median window comes out as the same step, in order
+void test_median_after_nan(void)
+{
+  Filter.Begin(FORCE_FILTER_MEDIAN, 80.0f, 10.0f, 3);
+
+  float Block[8] = { 1.0f, 2.0f, NAN, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f };
+  Filter.Process(Block, Block, 8);
+  for (uint32_t i = 1; i < 8; i++)
+  {
+    TEST_ASSERT_TRUE(Block[i] >= Block[i - 1]);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(6.0f, Block[7]);
+}
+
+// A 10 Hz cutoff at 10 SPS is past Nyquist, the design must still pass DC and be stable
+void test_slow_rate_design(void)
+{
+  Filter.Begin(FORCE_FILTER_BIQUAD, 10.0f, 10.0f, 1);
+
+  float Block[FORCE_FILTER_BLOCK_SIZE];
+  for (uint32_t n = 0; n < 16; n++)
+  {
+    for (uint32_t i = 0; i < FORCE_FILTER_BLOCK_SIZE; i++) Block[i] = (n == 0 && i == 0) ? 0.0f : 50.0f;
+    Filter.Process(Block, Block, FORCE_FILTER_BLOCK_SIZE);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.0f, Block[FORCE_FILTER_BLOCK_SIZE - 1]);
+  TEST_ASSERT_TRUE(Filter.GetDelay() >= 0.0f);
+  TEST_ASSERT_TRUE(Filter.GetDelayTime() < 1000000);
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_nan_biquad);
+  RUN_TEST(test_nan_fir);
+  RUN_TEST(test_nan_median);
+  RUN_TEST(test_median_after_nan);
+  RUN_TEST(test_slow_rate_design);
+  return UNITY_END();
+}
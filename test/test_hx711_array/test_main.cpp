@@ -0,0 +1,159 @@
+#include <unity.h>
+
+#include "Hx711Array.h"
+
+/* HX711 lockstep read-out against a memory port
+*
+* MemoryHx711Port plays the DOUT lines of up to HX711_CELLS bridges: each one
+* shifts its 24 bit code out MSB first on the rising SCK edges, like the chip does.
+*/
+
+class MemoryHx711Port
+{
+public:
+  Hx711Levels Read(void)
+  {
+    if (Pulses == 0 || Pulses > HX711_DATA_BITS) return Busy;
+
+    Hx711Levels Levels = 0;
+    for (uint8_t c = 0; c < 8; c++)
+    {
+      Levels |= Hx711Levels(((uint32_t(Codes[c]) >> (HX711_DATA_BITS - Pulses)) & 1) << c);
+    }
+    return Levels;
+  }
+
+  void Clock(bool Level)
+  {
+    if (Level && !Sck) Pulses++;
+    Sck = Level;
+  }
+
+  void Wait(void) {}
+
+  // Cells start the next conversion, Busy ones have not finished it yet
+  void Convert(const int32_t* NewCodes, uint8_t Count, Hx711Levels NewBusy = 0)
+  {
+    for (uint8_t c = 0; c < 8; c++) Codes[c] = c < Count ? NewCodes[c] : 0;
+    Busy = NewBusy;
+    Pulses = 0;
+  }
+
+  int32_t Codes[8] = {};
+  Hx711Levels Busy = 0;       // DOUT high: conversion running
+  uint8_t Pulses = 0;
+  bool Sck = false;
+};
+
+static Hx711Array Cells;
+static MemoryHx711Port Port;
+
+void setUp(void)
+{
+  Port = MemoryHx711Port();
+}
+
+void tearDown(void) {}
+
+static void test_codes_per_cell(void)
+{
+  const int32_t Codes[][HX711_CELLS] = {
+    { 0, 1, -1, 123456 },
+    { 0x7FFFFF, -0x800000, -654321, 0x5A5A5A },
+    { 0x000080, -2, 0x400000, -0x400000 }
+  };
+
+  Cells.Begin(HX711_CELLS, 1.0f);
+  for (const int32_t* Row : Codes)
+  {
+    Port.Convert(Row, HX711_CELLS);
+    TEST_ASSERT_TRUE(Cells.Update(Port));
+    for (uint8_t c = 0; c < HX711_CELLS; c++) TEST_ASSERT_EQUAL_INT32(Row[c], Cells.GetCode(c));
+
+    // 24 data pulses and the gain pulse, SCK left low so the chips stay powered
+    TEST_ASSERT_EQUAL_UINT8(HX711_DATA_BITS + HX711_GAIN_PULSES, Port.Pulses);
+    TEST_ASSERT_FALSE(Port.Sck);
+  }
+}
+
+static void test_waits_for_every_cell(void)
+{
+  const int32_t Codes[HX711_CELLS] = { 10, 20, 30, 40 };
+  Cells.Begin(3, 1.0f);
+
+  // Cell 2 still converting: nothing is clocked
+  Port.Convert(Codes, 3, 0x04);
+  TEST_ASSERT_FALSE(Cells.Update(Port));
+  TEST_ASSERT_EQUAL_UINT8(0, Port.Pulses);
+
+  // A busy line past the cell count does not hold the others back
+  Port.Convert(Codes, 3, 0xF8);
+  TEST_ASSERT_TRUE(Cells.Update(Port));
+  TEST_ASSERT_EQUAL_INT32(10, Cells.GetCode(0));
+  TEST_ASSERT_EQUAL_INT32(20, Cells.GetCode(1));
+  TEST_ASSERT_EQUAL_INT32(30, Cells.GetCode(2));
+}
+
+static void test_decode_levels(void)
+{
+  // Cell 0 reads 0x800001 (most negative + 1), cell 1 reads all ones (-1), the rest 0
+  Hx711Levels Levels[HX711_DATA_BITS] = {};
+  for (uint8_t i = 0; i < HX711_DATA_BITS; i++) Levels[i] = 0x02;
+  Levels[0] |= 0x01;
+  Levels[HX711_DATA_BITS - 1] |= 0x01;
+
+  Cells.Begin(HX711_CELLS, 1.0f);
+  Cells.Decode(Levels);
+  TEST_ASSERT_EQUAL_INT32(-0x7FFFFF, Cells.GetCode(0));
+  TEST_ASSERT_EQUAL_INT32(-1, Cells.GetCode(1));
+  TEST_ASSERT_EQUAL_INT32(0, Cells.GetCode(2));
+  TEST_ASSERT_EQUAL_INT32(0, Cells.GetCode(3));
+}
+
+static void test_tare_offsets(void)
+{
+  Cells.Begin(HX711_CELLS, 2.0f);
+  Cells.Tare();
+
+  // Every cell ramps around its own zero, the means are 1000, -5000, 7 and -8
+  for (int32_t i = 0; i < HX711_TARE_SAMPLES; i++)
+  {
+    TEST_ASSERT_TRUE(Cells.IsTaring());
+    int32_t Step = i - HX711_TARE_SAMPLES / 2;
+    const int32_t Codes[HX711_CELLS] = { 1000 + Step * 2 + 1, -5000 - Step * 2 - 1, 7, -8 };
+    Port.Convert(Codes, HX711_CELLS);
+    TEST_ASSERT_TRUE(Cells.Update(Port));
+  }
+  TEST_ASSERT_FALSE(Cells.IsTaring());
+
+  // The offsets show through GetData(): counts above the zero over the calibration factor
+  const int32_t Loaded[HX711_CELLS] = { 1000, -4000, 207, -8 };
+  Port.Convert(Loaded, HX711_CELLS);
+  TEST_ASSERT_TRUE(Cells.Update(Port));
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, Cells.GetData(0));
+  TEST_ASSERT_EQUAL_FLOAT(500.0f, Cells.GetData(1));
+  TEST_ASSERT_EQUAL_FLOAT(100.0f, Cells.GetData(2));
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, Cells.GetData(3));
+
+  // The raw codes are untouched by the tare
+  TEST_ASSERT_EQUAL_INT32(-4000, Cells.GetCode(1));
+}
+
+static void test_begin_clamps_count(void)
+{
+  Cells.Begin(0, 1.0f);
+  TEST_ASSERT_EQUAL_UINT8(1, Cells.GetCount());
+  Cells.Begin(HX711_CELLS + 3, 1.0f);
+  TEST_ASSERT_EQUAL_UINT8(HX711_CELLS, Cells.GetCount());
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_codes_per_cell);
+  RUN_TEST(test_waits_for_every_cell);
+  RUN_TEST(test_decode_levels);
+  RUN_TEST(test_tare_offsets);
+  RUN_TEST(test_begin_clamps_count);
+  return UNITY_END();
+}
@@ -0,0 +1,202 @@
+#include <unity.h>
+
+#include "Scheduler.h"
+
+/* Scheduler on a fake clock
+*
+* Task bodies advance the clock by their run time, so deadline misses, skipped
+* releases and lateness come out exactly.
+*/
+
+static uint64_t Now;
+static uint32_t Cost[2];       // us each task takes
+static uint32_t Order[16];
+static uint32_t OrderCount;
+
+static uint64_t FakeClock(void)
+{
+  return Now;
+}
+
+static void TaskA(void)
+{
+  if (OrderCount < 16) Order[OrderCount++] = 0;
+  Now += Cost[0];
+}
+
+static void TaskB(void)
+{
+  if (OrderCount < 16) Order[OrderCount++] = 1;
+  Now += Cost[1];
+}
+
+void setUp(void)
+{
+  Now = 0;
+  Cost[0] = Cost[1] = 0;
+  OrderCount = 0;
+}
+
+void tearDown(void) {}
+
+// Runs whatever is due until the clock reaches End, idling to the next release
+static void RunUntil(Scheduler& Tasks, uint64_t End)
+{
+  while (Now < End)
+  {
+    if (!Tasks.RunOnce())
+    {
+      uint64_t Next = Tasks.GetNextRelease();
+      Now = Next < End ? Next : End;
+    }
+  }
+}
+
+static void test_on_time(void)
+{
+  Scheduler Tasks(FakeClock);
+  int8_t Id = Tasks.Add("A", TaskA, 1000, 1);
+  Cost[0] = 100;
+
+  RunUntil(Tasks, 10000);
+  const SchedulerTask& Task = Tasks.GetTask(Id);
+  TEST_ASSERT_EQUAL_UINT32(10, Task.Runs);
+  TEST_ASSERT_EQUAL_UINT32(0, Task.DeadlineMisses);
+  TEST_ASSERT_EQUAL_UINT32(0, Task.SkippedReleases);
+  TEST_ASSERT_EQUAL_UINT32(0, Task.MaxLateness);
+  TEST_ASSERT_EQUAL_UINT64(10000, Tasks.GetNextRelease());
+}
+
+static void test_deadline_miss_skips_releases(void)
+{
+  Scheduler Tasks(FakeClock);
+  int8_t Id = Tasks.Add("A", TaskA, 1000, 1);
+
+  // Released at 0, finishes at 2500: misses its deadline at 1000, the releases at
+  // 1000 and 2000 are gone and the next one stays on the 1000 us grid
+  Cost[0] = 2500;
+  TEST_ASSERT_TRUE(Tasks.RunOnce());
+  const SchedulerTask& Task = Tasks.GetTask(Id);
+  TEST_ASSERT_EQUAL_UINT32(1, Task.DeadlineMisses);
+  TEST_ASSERT_EQUAL_UINT32(2, Task.SkippedReleases);
+  TEST_ASSERT_EQUAL_UINT64(3000, Tasks.GetNextRelease());
+
+  // Not due yet, and run once it is
+  Cost[0] = 0;
+  TEST_ASSERT_FALSE(Tasks.RunOnce());
+  Now = 3000;
+  TEST_ASSERT_TRUE(Tasks.RunOnce());
+  TEST_ASSERT_EQUAL_UINT32(2, Task.Runs);
+  TEST_ASSERT_EQUAL_UINT32(1, Task.DeadlineMisses);
+  TEST_ASSERT_EQUAL_UINT64(4000, Tasks.GetNextRelease());
+}
+
+static void test_finish_on_release(void)
+{
+  Scheduler Tasks(FakeClock);
+  int8_t Id = Tasks.Add("A", TaskA, 1000, 1);
+
+  // Ending exactly on the next release is not a miss, and that release still runs
+  Cost[0] = 1000;
+  Tasks.RunOnce();
+  TEST_ASSERT_EQUAL_UINT32(0, Tasks.GetTask(Id).DeadlineMisses);
+  TEST_ASSERT_EQUAL_UINT32(0, Tasks.GetTask(Id).SkippedReleases);
+  TEST_ASSERT_EQUAL_UINT64(1000, Tasks.GetNextRelease());
+
+  // Overrunning into a later release that it ends right on only skips the ones in between
+  Cost[0] = 2000;
+  Now = 1000;
+  Tasks.RunOnce();
+  TEST_ASSERT_EQUAL_UINT32(1, Tasks.GetTask(Id).DeadlineMisses);
+  TEST_ASSERT_EQUAL_UINT32(1, Tasks.GetTask(Id).SkippedReleases);
+  TEST_ASSERT_EQUAL_UINT64(3000, Tasks.GetNextRelease());
+
+  // A run time equal to the period keeps the full rate
+  Tasks.ResetStats();
+  Cost[0] = 1000;
+  RunUntil(Tasks, 13000);
+  TEST_ASSERT_EQUAL_UINT32(10, Tasks.GetTask(Id).Runs);
+  TEST_ASSERT_EQUAL_UINT32(0, Tasks.GetTask(Id).DeadlineMisses);
+  TEST_ASSERT_EQUAL_UINT32(0, Tasks.GetTask(Id).SkippedReleases);
+}
+
+static void test_late_start(void)
+{
+  Scheduler Tasks(FakeClock);
+  int8_t Id = Tasks.Add("A", TaskA, 1000, 1);
+
+  // Started 400 us after its release and done within the period
+  Now = 400;
+  Cost[0] = 100;
+  Tasks.RunOnce();
+  TEST_ASSERT_EQUAL_UINT32(400, Tasks.GetTask(Id).MaxLateness);
+  TEST_ASSERT_EQUAL_UINT32(0, Tasks.GetTask(Id).DeadlineMisses);
+  TEST_ASSERT_EQUAL_UINT32(0, Tasks.GetTask(Id).SkippedReleases);
+  TEST_ASSERT_EQUAL_UINT64(1000, Tasks.GetNextRelease());
+}
+
+static void test_priority_blocks_lower(void)
+{
+  Scheduler Tasks(FakeClock);
+  int8_t Low = Tasks.Add("A", TaskA, 1000, 1);
+  int8_t High = Tasks.Add("B", TaskB, 1000, 2);
+
+  // Both due at 0, the higher priority runs first and makes the other one late
+  Cost[1] = 1500;
+  TEST_ASSERT_TRUE(Tasks.RunOnce());
+  TEST_ASSERT_TRUE(Tasks.RunOnce());
+  TEST_ASSERT_EQUAL_UINT32(2, OrderCount);
+  TEST_ASSERT_EQUAL_UINT32(1, Order[0]);
+  TEST_ASSERT_EQUAL_UINT32(0, Order[1]);
+
+  const SchedulerTask& LowTask = Tasks.GetTask(Low);
+  TEST_ASSERT_EQUAL_UINT32(1500, LowTask.MaxLateness);
+  TEST_ASSERT_EQUAL_UINT32(1, LowTask.DeadlineMisses);
+  TEST_ASSERT_EQUAL_UINT32(1, LowTask.SkippedReleases);
+  TEST_ASSERT_EQUAL_UINT32(1, Tasks.GetTask(High).DeadlineMisses);
+  TEST_ASSERT_EQUAL_UINT32(1, Tasks.GetTask(High).SkippedReleases);
+}
+
+static void test_disabled_and_stats(void)
+{
+  Scheduler Tasks(FakeClock);
+  int8_t Id = Tasks.Add("A", TaskA, 1000, 1);
+  Cost[0] = 2500;
+  Tasks.RunOnce();
+
+  Tasks.SetEnabled(Id, false);
+  TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, Tasks.GetNextRelease());
+  Now = 10000;
+  TEST_ASSERT_FALSE(Tasks.RunOnce());
+
+  // Enabling again releases it right away, without counting the time it was off
+  Tasks.ResetStats();
+  Tasks.SetEnabled(Id, true);
+  TEST_ASSERT_EQUAL_UINT64(10000, Tasks.GetNextRelease());
+  Cost[0] = 0;
+  TEST_ASSERT_TRUE(Tasks.RunOnce());
+  TEST_ASSERT_EQUAL_UINT32(1, Tasks.GetTask(Id).Runs);
+  TEST_ASSERT_EQUAL_UINT32(0, Tasks.GetTask(Id).DeadlineMisses);
+  TEST_ASSERT_EQUAL_UINT32(0, Tasks.GetTask(Id).SkippedReleases);
+}
+
+static void test_table_full(void)
+{
+  Scheduler Tasks(FakeClock);
+  for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) TEST_ASSERT_EQUAL_INT(i, Tasks.Add("A", TaskA, 1000, 1));
+  TEST_ASSERT_EQUAL_INT(-1, Tasks.Add("A", TaskA, 1000, 1));
+  TEST_ASSERT_EQUAL_UINT8(SCHEDULER_MAX_TASKS, Tasks.GetTaskCount());
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_on_time);
+  RUN_TEST(test_deadline_miss_skips_releases);
+  RUN_TEST(test_finish_on_release);
+  RUN_TEST(test_late_start);
+  RUN_TEST(test_priority_blocks_lower);
+  RUN_TEST(test_disabled_and_stats);
+  RUN_TEST(test_table_full);
+  return UNITY_END();
+}
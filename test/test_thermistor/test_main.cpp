@@ -0,0 +1,110 @@
+#include <unity.h>
+
+#include "Config.h"
+#include "Thermistor.h"
+
+#include <math.h>
+
+/* The lookup table against the formula it replaced
+*
+* ThermistorFloat() is ReadThermistor() as it was before the table, single precision
+* and libm, so the table has to reproduce what the logs used to contain.
+*/
+
+#define TOLERANCE                       0.005f  // Table against the float formula, deg C
+#define INTERPOLATION_TOLERANCE         0.02f   // 12 bit codes between two entries, deg C
+#define INTERPOLATION_MIN               -30.0f  // Range the interpolation is held to, deg C
+#define INTERPOLATION_MAX               150.0f
+
+static constexpr ThermistorTable Table1(THERMISTOR_1_RESISTANCE, THERMISTOR_CALIBRATION_OFFSET);
+static constexpr ThermistorTable Table2(THERMISTOR_2_RESISTANCE, THERMISTOR_CALIBRATION_OFFSET);
+
+static float ThermistorFloat(float Code, float FullScale, float Resistance)
+{
+  const float c1 = 1.009249522e-03, c2 = 2.378405444e-04, c3 = 2.019202697e-07;
+  float Vo = (3.3f / FullScale) * Code;
+  float R1 = Resistance * (3.3f - Vo) / Vo;
+  float logR2 = log(R1);
+  float T = (1.0 / (c1 + c2 * logR2 + c3 * logR2 * logR2 * logR2));
+  T = T - 273.15f;
+  return T + THERMISTOR_CALIBRATION_OFFSET;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void CheckTable(const ThermistorTable& Table, float Resistance)
+{
+  char Message[48];
+  for (uint32_t Code = 1; Code < THERMISTOR_TABLE_SIZE; Code++)
+  {
+    snprintf(Message, sizeof(Message), "code %lu", (unsigned long) Code);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(TOLERANCE, ThermistorFloat(Code, 1024.0f, Resistance), Table.Convert(Code), Message);
+  }
+}
+
+static void test_table_matches_formula_1(void)
+{
+  CheckTable(Table1, THERMISTOR_1_RESISTANCE);
+}
+
+static void test_table_matches_formula_2(void)
+{
+  CheckTable(Table2, THERMISTOR_2_RESISTANCE);
+}
+
+static void test_open_divider(void)
+{
+  TEST_ASSERT_EQUAL_FLOAT(-273.15f + THERMISTOR_CALIBRATION_OFFSET, Table1.Convert(0));
+}
+
+static void test_12_bit_on_entries(void)
+{
+  // Codes that land on an entry are the entry, bit for bit
+  for (uint32_t Code = 0; Code < THERMISTOR_TABLE_SIZE; Code++)
+  {
+    TEST_ASSERT_TRUE(Table1.Convert(Code << 2, 12) == Table1[Code]);
+  }
+}
+
+static void test_12_bit_between_entries(void)
+{
+  char Message[48];
+  for (uint32_t Code = 4; Code < (THERMISTOR_TABLE_SIZE - 1) << 2; Code++)
+  {
+    float Value = Table1.Convert(Code, 12);
+    float Low = Table1[Code >> 2];
+    float High = Table1[(Code >> 2) + 1];
+    snprintf(Message, sizeof(Message), "code %lu", (unsigned long) Code);
+
+    // Monotonic between the two neighbours, and close to the curve in the range the test stand sees
+    TEST_ASSERT_TRUE_MESSAGE(Value >= Low && Value <= High, Message);
+    float Expected = ThermistorFloat(Code, 4096.0f, THERMISTOR_1_RESISTANCE);
+    if (Expected > INTERPOLATION_MIN && Expected < INTERPOLATION_MAX)
+    {
+      TEST_ASSERT_FLOAT_WITHIN_MESSAGE(INTERPOLATION_TOLERANCE, Expected, Value, Message);
+    }
+  }
+}
+
+static void test_12_bit_top_of_range(void)
+{
+  // Past the last entry there is nothing to interpolate towards
+  float Last = Table1[THERMISTOR_TABLE_SIZE - 1];
+  for (uint32_t Code = (THERMISTOR_TABLE_SIZE - 1) << 2; Code < 4096; Code++)
+  {
+    TEST_ASSERT_EQUAL_FLOAT(Last, Table1.Convert(Code, 12));
+  }
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_table_matches_formula_1);
+  RUN_TEST(test_table_matches_formula_2);
+  RUN_TEST(test_open_divider);
+  RUN_TEST(test_12_bit_on_entries);
+  RUN_TEST(test_12_bit_between_entries);
+  RUN_TEST(test_12_bit_top_of_range);
+  return UNITY_END();
+}
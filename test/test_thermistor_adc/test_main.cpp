@@ -0,0 +1,137 @@
+#include <unity.h>
+
+#include "ThermistorAdcSim.h"
+
+/* Background acquisition without the hardware
+*
+* Blocks come from ThermistorAdcSimulateBlock() or are handed to OnBlockComplete()
+* directly, so the decimation, the dropped settle samples and the round robin are the
+* code that runs in the DMA ISR.
+*/
+
+static const uint8_t PINS[] = { 24, 25, 15 };
+
+struct SourceState
+{
+  uint32_t Calls[64];
+};
+
+// Pin 24 alternates 1000/1001, pin 25 sits at 3000, anything else at 10
+static uint16_t Source(void* Context, uint8_t Pin)
+{
+  SourceState* State = (SourceState*) Context;
+  uint32_t Call = State->Calls[Pin]++;
+  if (Pin == 24) return uint16_t(1000 + (Call & 1));
+  if (Pin == 25) return 3000;
+  return 10;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_decimate_rounds(void)
+{
+  const uint16_t Up[] = { 1, 2 };
+  const uint16_t Down[] = { 1, 1, 2 };
+  const uint16_t Full[] = { 4095, 4095, 4095, 4094 };
+  TEST_ASSERT_EQUAL_UINT16(2, ThermistorAdcDecimate(Up, 2));
+  TEST_ASSERT_EQUAL_UINT16(1, ThermistorAdcDecimate(Down, 3));
+  TEST_ASSERT_EQUAL_UINT16(4095, ThermistorAdcDecimate(Full, 4));
+  TEST_ASSERT_EQUAL_UINT16(0, ThermistorAdcDecimate(Up, 0));
+}
+
+static void test_settle_samples_dropped(void)
+{
+  ThermistorAdc Adc;
+  Adc.Begin(PINS, 2);
+
+  // Left over from the previous channel, then the real level
+  uint16_t Block[THERMISTOR_ADC_BLOCK_SIZE];
+  for (uint32_t i = 0; i < THERMISTOR_ADC_BLOCK_SIZE; i++) Block[i] = i < THERMISTOR_ADC_SETTLE_SAMPLES ? 4095 : 2000;
+  Adc.OnBlockComplete(Block, THERMISTOR_ADC_BLOCK_SIZE, 1234);
+
+  ThermistorAdcReading Reading = Adc.GetLatest(0);
+  TEST_ASSERT_EQUAL_UINT16(2000, Reading.Code);
+  TEST_ASSERT_EQUAL_UINT64(1234, Reading.Time);
+}
+
+static void test_short_block_ignored(void)
+{
+  ThermistorAdc Adc;
+  Adc.Begin(PINS, 2);
+
+  // Nothing left once the settle samples are gone, the channel still moves on
+  uint16_t Block[THERMISTOR_ADC_SETTLE_SAMPLES] = { 500, 500 };
+  TEST_ASSERT_EQUAL_UINT8(1, Adc.OnBlockComplete(Block, THERMISTOR_ADC_SETTLE_SAMPLES, 10));
+  TEST_ASSERT_EQUAL_UINT16(0, Adc.GetLatest(0).Code);
+  TEST_ASSERT_EQUAL_UINT32(0, Adc.GetBlockCount(0));
+}
+
+static void test_round_robin(void)
+{
+  ThermistorAdc Adc;
+  Adc.Begin(PINS, 3);
+  uint16_t Block[THERMISTOR_ADC_BLOCK_SIZE] = {};
+
+  TEST_ASSERT_EQUAL_UINT8(0, Adc.GetActiveChannel());
+  for (uint32_t i = 0; i < 9; i++)
+  {
+    TEST_ASSERT_EQUAL_UINT8((i + 1) % 3, Adc.OnBlockComplete(Block, THERMISTOR_ADC_BLOCK_SIZE, i));
+    TEST_ASSERT_EQUAL_UINT8((i + 1) % 3, Adc.GetActiveChannel());
+  }
+  for (uint8_t Channel = 0; Channel < 3; Channel++) TEST_ASSERT_EQUAL_UINT32(3, Adc.GetBlockCount(Channel));
+}
+
+static void test_channel_count_clamped(void)
+{
+  const uint8_t Many[THERMISTOR_ADC_CHANNELS + 2] = { 1, 2, 3, 4, 5, 6 };
+  ThermistorAdc Adc;
+  Adc.Begin(Many, THERMISTOR_ADC_CHANNELS + 2);
+  TEST_ASSERT_EQUAL_UINT8(THERMISTOR_ADC_CHANNELS, Adc.GetChannelCount());
+
+  Adc.Begin(PINS, 0);
+  TEST_ASSERT_EQUAL_UINT8(1, Adc.GetChannelCount());
+  TEST_ASSERT_EQUAL_UINT8(PINS[0], Adc.GetPin(0));
+}
+
+static void test_simulated_blocks(void)
+{
+  SourceState State = {};
+  ThermistorAdc Adc;
+  Adc.Begin(PINS, 2);
+  TEST_ASSERT_TRUE(ThermistorAdcSimInstance() == &Adc);
+
+  // Alternates between the two pins, one block each per call
+  for (uint32_t i = 0; i < 6; i++)
+  {
+    TEST_ASSERT_EQUAL_UINT8(PINS[i % 2], Adc.GetPin(Adc.GetActiveChannel()));
+    ThermistorAdcSimulateBlock(Adc, Source, &State, 100 * (i + 1));
+  }
+
+  // Hardware averaging of 1000/1001 rounds to 1001, the block mean keeps it
+  ThermistorAdcReading First = Adc.GetLatest(0);
+  ThermistorAdcReading Second = Adc.GetLatest(1);
+  TEST_ASSERT_EQUAL_UINT16(1001, First.Code);
+  TEST_ASSERT_EQUAL_UINT64(500, First.Time);
+  TEST_ASSERT_EQUAL_UINT16(3000, Second.Code);
+  TEST_ASSERT_EQUAL_UINT64(600, Second.Time);
+  TEST_ASSERT_EQUAL_UINT32(3, Adc.GetBlockCount(0));
+  TEST_ASSERT_EQUAL_UINT32(3, Adc.GetBlockCount(1));
+
+  // Every block was THERMISTOR_ADC_AVERAGING conversions per sample of its own pin
+  TEST_ASSERT_EQUAL_UINT32(3 * THERMISTOR_ADC_BLOCK_SIZE * THERMISTOR_ADC_AVERAGING, State.Calls[24]);
+  TEST_ASSERT_EQUAL_UINT32(3 * THERMISTOR_ADC_BLOCK_SIZE * THERMISTOR_ADC_AVERAGING, State.Calls[25]);
+  TEST_ASSERT_EQUAL_UINT32(0, State.Calls[15]);
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_decimate_rounds);
+  RUN_TEST(test_settle_samples_dropped);
+  RUN_TEST(test_short_block_ignored);
+  RUN_TEST(test_round_robin);
+  RUN_TEST(test_channel_count_clamped);
+  RUN_TEST(test_simulated_blocks);
+  return UNITY_END();
+}
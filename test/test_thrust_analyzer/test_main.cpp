@@ -0,0 +1,123 @@
+#include <unity.h>
+
+#include "Config.h"
+#include "ThrustAnalyzer.h"
+
+#include "../fixtures/Fixture.h"
+
+/* Thrust curve results on known curves
+*
+* Every fixture only has samples at zero or above the onset threshold while the
+* motor burns, so the trapezoidal impulse is the exact area of the curve.
+*/
+
+#define IMPULSE_TOLERANCE               0.01f   // Ns
+#define TIME_TOLERANCE                  1e-6f   // s
+
+static Fixture Curve;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static ThrustResults Analyze(const char* Name)
+{
+  TEST_ASSERT_TRUE_MESSAGE(FixtureLoad(Name, Curve), Name);
+
+  ThrustAnalyzer Analyzer(ANALYSIS_ONSET_THRESHOLD, ANALYSIS_BURNOUT_THRESHOLD);
+  Analyzer.Reset();
+  for (uint32_t i = 0; i < Curve.Count; i++) Analyzer.Update(Curve.Time[i], Curve.Force[i]);
+  return Analyzer.GetResults();
+}
+
+static void test_square(void)
+{
+  // 100 N from 1 s to 3 s at 80 Hz, the edges ramp over one sample each
+  ThrustResults Results = Analyze("square.csv");
+  TEST_ASSERT_TRUE(Results.Ignited);
+  TEST_ASSERT_TRUE(Results.BurnedOut);
+  TEST_ASSERT_FLOAT_WITHIN(IMPULSE_TOLERANCE, 200.0f, Results.TotalImpulse);
+  TEST_ASSERT_EQUAL_FLOAT(100.0f, Results.PeakThrust);
+  TEST_ASSERT_EQUAL_UINT64(1000000, Results.PeakTime);
+  TEST_ASSERT_EQUAL_UINT64(1000000, Results.OnsetTime);
+  TEST_ASSERT_EQUAL_UINT64(3000000, Results.BurnoutTime);
+  TEST_ASSERT_FLOAT_WITHIN(TIME_TOLERANCE, 2.0f, Results.BurnTime);
+  TEST_ASSERT_FLOAT_WITHIN(IMPULSE_TOLERANCE, 100.0f, Results.AverageThrust);
+  TEST_ASSERT_EQUAL_STRING("H", ThrustAnalyzer::MotorClass(Results.TotalImpulse));
+}
+
+static void test_trapezoid_jitter(void)
+{
+  // 0.1 s ramps either side of 1 s at 80 N, samples 7 and 13 ms apart
+  ThrustResults Results = Analyze("trapezoid_jitter.csv");
+  TEST_ASSERT_TRUE(Results.BurnedOut);
+  TEST_ASSERT_FLOAT_WITHIN(IMPULSE_TOLERANCE, 88.0f, Results.TotalImpulse);
+  TEST_ASSERT_EQUAL_FLOAT(80.0f, Results.PeakThrust);
+  TEST_ASSERT_EQUAL_UINT64(200000, Results.PeakTime);
+
+  // First sample at or above 5 N is 5.6 N at 107 ms, first one below 2 N is 0 at 1.3 s
+  TEST_ASSERT_EQUAL_UINT64(107000, Results.OnsetTime);
+  TEST_ASSERT_EQUAL_UINT64(1300000, Results.BurnoutTime);
+  TEST_ASSERT_FLOAT_WITHIN(TIME_TOLERANCE, 1.193f, Results.BurnTime);
+  TEST_ASSERT_EQUAL_STRING("G", ThrustAnalyzer::MotorClass(Results.TotalImpulse));
+}
+
+static void test_chuff_resumes_burn(void)
+{
+  // 40 N for 0.5 s, out for 0.2 s, 40 N for 0.3 s
+  ThrustResults Results = Analyze("chuff.csv");
+  TEST_ASSERT_TRUE(Results.BurnedOut);
+  TEST_ASSERT_FLOAT_WITHIN(IMPULSE_TOLERANCE, 32.0f, Results.TotalImpulse);
+  TEST_ASSERT_EQUAL_UINT64(500000, Results.OnsetTime);
+  TEST_ASSERT_EQUAL_UINT64(1500000, Results.BurnoutTime);
+  TEST_ASSERT_FLOAT_WITHIN(TIME_TOLERANCE, 1.0f, Results.BurnTime);
+  TEST_ASSERT_EQUAL_STRING("E", ThrustAnalyzer::MotorClass(Results.TotalImpulse));
+}
+
+static void test_no_ignition(void)
+{
+  ThrustAnalyzer Analyzer(ANALYSIS_ONSET_THRESHOLD, ANALYSIS_BURNOUT_THRESHOLD);
+  for (uint32_t i = 0; i < 100; i++) Analyzer.Update(i * 12500, 4.9f);
+
+  const ThrustResults& Results = Analyzer.GetResults();
+  TEST_ASSERT_FALSE(Results.Ignited);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, Results.TotalImpulse);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, Results.BurnTime);
+  TEST_ASSERT_EQUAL_STRING("-", ThrustAnalyzer::MotorClass(Results.TotalImpulse));
+}
+
+static void test_motor_class_boundaries(void)
+{
+  // Upper bounds are inclusive: 1/8A ends at 0.3125 Ns, every class doubles it
+  static const char* const Classes[] = {
+    "1/8A", "1/4A", "1/2A", "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M", "N", "O"
+  };
+
+  TEST_ASSERT_EQUAL_STRING("-", ThrustAnalyzer::MotorClass(0.0f));
+  TEST_ASSERT_EQUAL_STRING("-", ThrustAnalyzer::MotorClass(-1.0f));
+  TEST_ASSERT_EQUAL_STRING("1/8A", ThrustAnalyzer::MotorClass(0.01f));
+
+  float Upper = 0.3125f;
+  for (uint8_t i = 0; i < sizeof(Classes) / sizeof(Classes[0]); i++)
+  {
+    TEST_ASSERT_EQUAL_STRING(Classes[i], ThrustAnalyzer::MotorClass(Upper));
+    TEST_ASSERT_EQUAL_STRING(Classes[i], ThrustAnalyzer::MotorClass(Upper * 0.999f));
+    if (i > 0) TEST_ASSERT_EQUAL_STRING(Classes[i], ThrustAnalyzer::MotorClass(Upper * 0.501f));
+    Upper *= 2;
+  }
+
+  TEST_ASSERT_EQUAL_STRING("A", ThrustAnalyzer::MotorClass(2.5f));
+  TEST_ASSERT_EQUAL_STRING("B", ThrustAnalyzer::MotorClass(2.51f));
+  TEST_ASSERT_EQUAL_STRING("O", ThrustAnalyzer::MotorClass(40960.0f));
+  TEST_ASSERT_EQUAL_STRING(">O", ThrustAnalyzer::MotorClass(40961.0f));
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_square);
+  RUN_TEST(test_trapezoid_jitter);
+  RUN_TEST(test_chuff_resumes_burn);
+  RUN_TEST(test_no_ignition);
+  RUN_TEST(test_motor_class_boundaries);
+  return UNITY_END();
+}
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""Convert a binary test log written by LogRecorder into the CSV layout.
+
+Usage: decode_log.py "Motor Test Data #42.bin" [output.csv]
+
+Without an output path the CSV is written to stdout. The pipeline accounting
+from the trailer of a version 3 or later log goes to stderr. Version 4 logs
+describe their channels after the header, every channel becomes a column.
+Version 5 adds the force filter and its group delay, also reported on stderr.
+
+The header sample rate is only the rate outside burst mode. The pre-trigger
+history and the burst records hold every conversion, so the records are placed
+by their own timestamps, never by index / rate.
+"""
+
+import struct
+import sys
+
+LOG_FILE_MAGIC = 0x4C545354
+HEADER = struct.Struct("<IHHHHH2x")      # trailer size is 0 before version 3, channel count before 4
+HEADER_V5 = struct.Struct("<IHHHHHBxI")   # plus filter type and its group delay in us
+FILTERS = ["none", "biquad", "FIR", "median"]
+RECORD_V1 = struct.Struct("<Ifff")        # ms timestamp
+RECORD_V2 = struct.Struct("<Qfffi")       # us timestamp, temperature age
+CHANNEL = struct.Struct("<16s8sBBH")      # name, unit, type, source, offset into the record
+CHANNEL_TYPES = {0: ("f", "%.2f"), 1: ("i", "%d")}
+
+LOG_TRAILER_MAGIC = 0x444E4554
+TRAILER = struct.Struct("<IIII")          # magic, acquisition, recorder and telemetry drops
+CONSUMER = struct.Struct("<IIIIIB3x")     # pushed, dropped, decimated, high water, max age, policy
+CONSUMERS = ["Log", "Telemetry", "Display"]
+POLICIES = ["drop newest", "drop oldest", "decimate"]
+
+CSV_HEADER = "Time (s), Force (N), Temperature #1 (*C), Temperature #2 (*C)"
+
+
+def decode(data, out):
+    if len(data) < HEADER.size:
+        raise ValueError("file too short for a header")
+
+    magic, version, record_size, sample_rate, trailer_size, channel_count = HEADER.unpack_from(data, 0)
+    if magic != LOG_FILE_MAGIC:
+        raise ValueError("not a test stand log (magic 0x%08X)" % magic)
+    header_size = HEADER.size
+    if version >= 5:
+        if len(data) < HEADER_V5.size:
+            raise ValueError("file too short for a header")
+        filter_type, filter_delay = HEADER_V5.unpack_from(data, 0)[6:]
+        header_size = HEADER_V5.size
+        sys.stderr.write("force filter %s, group delay %.1f ms\n" % (
+            FILTERS[filter_type] if filter_type < len(FILTERS) else str(filter_type), filter_delay / 1000.0))
+    if version == 1 and record_size == RECORD_V1.size:
+        record, time_scale, time_format = RECORD_V1, 1e-3, "%.3f"
+        columns, formats = CSV_HEADER, ["%.2f"] * 3
+    elif version in (2, 3) and record_size == RECORD_V2.size:
+        record, time_scale, time_format = RECORD_V2, 1e-6, "%.6f"
+        columns, formats = CSV_HEADER, ["%.2f"] * 3
+    elif version in (4, 5):
+        table = header_size
+        header_size += channel_count * CHANNEL.size
+        if len(data) < header_size:
+            raise ValueError("file too short for its channel table")
+        record, columns, formats = channel_layout(data[table:header_size], channel_count, record_size)
+        time_scale, time_format = 1e-6, "%.6f"
+    else:
+        raise ValueError("unsupported log version %d (record size %d)" % (version, record_size))
+
+    out.write(columns + "\n")
+    line = ", ".join([time_format] + formats) + "\n"
+
+    body = data[header_size:]
+    if version >= 3 and len(body) >= trailer_size >= TRAILER.size:
+        trailer = body[len(body) - trailer_size:]
+        if TRAILER.unpack_from(trailer, 0)[0] == LOG_TRAILER_MAGIC:
+            report_trailer(trailer)
+            body = body[:len(body) - trailer_size]
+        else:
+            sys.stderr.write("warning: no trailer, the test was not closed normally\n")
+    count = len(body) // record_size
+    for i in range(count):
+        fields = record.unpack_from(body, i * record_size)
+        out.write(line % ((fields[0] * time_scale,) + fields[1:len(formats) + 1]))
+
+    if len(body) % record_size:
+        sys.stderr.write("warning: ignoring %d trailing bytes\n" % (len(body) % record_size))
+    return count
+
+
+def channel_layout(table, count, record_size):
+    """Record struct, CSV header and value formats from a version 4 or later channel table."""
+    layout = "<Q"
+    position = 8
+    columns = ["Time (s)"]
+    formats = []
+    for i in range(count):
+        name, unit, kind, _, offset = CHANNEL.unpack_from(table, i * CHANNEL.size)
+        if kind not in CHANNEL_TYPES or offset < position:
+            raise ValueError("bad channel table entry %d" % i)
+        layout += "%dx%s" % (offset - position, CHANNEL_TYPES[kind][0]) if offset > position else CHANNEL_TYPES[kind][0]
+        position = offset + 4
+        formats.append(CHANNEL_TYPES[kind][1])
+        columns.append("%s (%s)" % (name.rstrip(b"\0").decode("ascii"), unit.rstrip(b"\0").decode("ascii")))
+    if position > record_size:
+        raise ValueError("channels overrun the %d byte record" % record_size)
+    layout += "%dx" % (record_size - position) if record_size > position else ""
+    return struct.Struct(layout), ", ".join(columns), formats
+
+
+def report_trailer(trailer):
+    _, acquisition, recorder, telemetry = TRAILER.unpack_from(trailer, 0)
+    sys.stderr.write("acquisition dropped %d, recorder dropped %d, telemetry frames dropped %d\n" % (
+        acquisition, recorder, telemetry))
+
+    count = (len(trailer) - TRAILER.size) // CONSUMER.size
+    for i in range(count):
+        pushed, dropped, decimated, high_water, max_age, policy = CONSUMER.unpack_from(trailer, TRAILER.size + i * CONSUMER.size)
+        name = CONSUMERS[i] if i < len(CONSUMERS) else "#%d" % i
+        policy = POLICIES[policy] if policy < len(POLICIES) else str(policy)
+        sys.stderr.write("%-10s %-12s pushed %d, dropped %d, decimated %d, high water %d, max age %d us\n" % (
+            name, policy, pushed, dropped, decimated, high_water, max_age))
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.stderr.write(__doc__)
+        return 2
+
+    with open(argv[1], "rb") as f:
+        data = f.read()
+
+    if len(argv) == 3:
+        with open(argv[2], "w", newline="") as out:
+            decode(data, out)
+    else:
+        decode(data, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
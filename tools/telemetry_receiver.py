@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+"""Decode the live telemetry stream from the test stand into CSV.
+
+Usage: telemetry_receiver.py PORT [output.csv]
+
+PORT is the Teensy's USB serial device (/dev/ttyACM0, COM ports via pyserial),
+the pseudo terminal printed by the native simulator's --pty option, a capture
+file such as the simulator's telemetry.bin, or - for stdin. Rows are written as
+frames arrive, to stdout without an output path. Console text sent between the
+frames goes to stderr. Ctrl-C or the end of the stream prints the statistics.
+
+The stand announces its channels in layout frames, at boot and once a second.
+The CSV header is written, and samples are decoded, once the layout is complete.
+
+Frame layout (Telemetry.h): 0x00 | COBS(header + payload + CRC-32) | 0x00
+"""
+
+import os
+import struct
+import sys
+import zlib
+
+HEADER = struct.Struct("<BIQ")            # type, sequence, us since boot
+CHANNEL = struct.Struct("<BB16s8sBBH")   # index, count, name, unit, type, source, offset into the record
+CRC = struct.Struct("<I")
+
+TELEMETRY_SAMPLE = 1
+TELEMETRY_CHANNEL = 2
+RECORD_TIME_SIZE = 8                      # Sample payloads start at the record's channel data
+CHANNEL_TYPES = {0: ("f", "%.2f"), 1: ("i", "%d")}
+STATES = ["STARTUP", "ERROR", "READY_FOR_COUNTDOWN", "COUNTDOWN", "TEST_ACTIVE", "POST_TEST"]
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            return None
+        block = data[i:i + code - 1]
+        if 0 in block:
+            return None
+        out += block
+        i += code - 1
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def is_text(chunk):
+    return all(0x20 <= b < 0x7F or b in (0x09, 0x0A, 0x0D) for b in chunk)
+
+
+class Receiver:
+    def __init__(self, out, console):
+        self.out = out
+        self.console = console
+        self.pending = bytearray()
+        self.next_sequence = None
+        self.frames = 0
+        self.dropped = 0
+        self.corrupt = 0
+        self.restarts = 0
+        self.text_bytes = 0
+        self.skipped = 0
+        self.channels = {}
+        self.layout = None
+
+    def feed(self, data):
+        self.pending += data
+        *chunks, self.pending = self.pending.split(b"\x00")
+        for chunk in chunks:
+            if chunk:
+                self.chunk(bytes(chunk))
+
+    def finish(self):
+        # Console text at the very end has no delimiter after it
+        if self.pending:
+            self.chunk(bytes(self.pending))
+            self.pending = bytearray()
+
+    def chunk(self, chunk):
+        raw = cobs_decode(chunk)
+        if raw is None or len(raw) < HEADER.size + CRC.size \
+                or CRC.unpack_from(raw, len(raw) - CRC.size)[0] != zlib.crc32(raw[:-CRC.size]):
+            if is_text(chunk):
+                self.text_bytes += len(chunk)
+                self.console.write(chunk.decode("ascii"))
+                self.console.flush()
+            else:
+                self.corrupt += 1
+            return
+
+        frame_type, sequence, time = HEADER.unpack_from(raw, 0)
+        payload = raw[HEADER.size:-CRC.size]
+
+        if self.next_sequence is not None and sequence != self.next_sequence:
+            if sequence > self.next_sequence:
+                self.dropped += sequence - self.next_sequence
+            else:
+                # The stand was reset, numbering starts over
+                self.restarts += 1
+        self.next_sequence = (sequence + 1) & 0xFFFFFFFF
+        self.frames += 1
+
+        if frame_type == TELEMETRY_CHANNEL and len(payload) == CHANNEL.size:
+            self.channel(CHANNEL.unpack(payload))
+        elif frame_type == TELEMETRY_SAMPLE:
+            if self.layout is None or len(payload) != self.layout[0].size:
+                # Before the first layout, or from a stand with other channels
+                self.skipped += 1
+                return
+            record, formats = self.layout
+            *values, state = record.unpack(payload)
+            name = STATES[state] if state < len(STATES) else str(state)
+            line = ", ".join(["%.6f", "%d", "%s"] + formats) + "\n"
+            self.out.write(line % tuple([time * 1e-6, sequence, name] + values))
+            self.out.flush()
+
+    def channel(self, fields):
+        index, count, name, unit, kind, _, offset = fields
+        if kind not in CHANNEL_TYPES:
+            return
+        if any(entry[0] != count for entry in self.channels.values()):
+            # A restarted stand with a different channel set
+            self.channels = {}
+        self.channels[index] = (count, name.rstrip(b"\0").decode("ascii"), unit.rstrip(b"\0").decode("ascii"), kind, offset)
+        if self.layout is not None or len(self.channels) != count:
+            return
+
+        layout = "<"
+        position = 0
+        columns = ["Time (s)", "Sequence", "State"]
+        formats = []
+        for i in range(count):
+            _, name, unit, kind, offset = self.channels[i]
+            offset -= RECORD_TIME_SIZE
+            layout += ("%dx" % (offset - position) if offset > position else "") + CHANNEL_TYPES[kind][0]
+            position = offset + 4
+            columns.append("%s (%s)" % (name, unit))
+            formats.append(CHANNEL_TYPES[kind][1])
+        self.layout = (struct.Struct(layout + "B"), formats)
+        self.out.write(", ".join(columns) + "\n")
+        self.out.flush()
+
+    def report(self):
+        total = self.frames + self.dropped
+        sys.stderr.write("%d frames, %d dropped (%.2f%%), %d corrupt, %d restarts, %d console bytes, %d samples without layout\n" % (
+            self.frames, self.dropped, 100.0 * self.dropped / total if total else 0.0,
+            self.corrupt, self.restarts, self.text_bytes, self.skipped))
+
+
+def open_port(path):
+    if path == "-":
+        return sys.stdin.buffer.fileno()
+    try:
+        fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    except OSError:
+        # Not a device node, e.g. a Windows COM port
+        import serial
+        port = serial.Serial(path, timeout=None)
+        return port
+    if os.isatty(fd):
+        import termios
+        import tty
+        # TCSANOW, the default would flush whatever the stand already sent
+        tty.setraw(fd, termios.TCSANOW)
+    return fd
+
+
+def read_chunk(port):
+    if isinstance(port, int):
+        try:
+            return os.read(port, 4096)
+        except OSError:
+            # A pty whose writer went away
+            return b""
+    return port.read(max(1, port.in_waiting))
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.stderr.write(__doc__)
+        return 2
+
+    out = open(argv[2], "w", newline="") if len(argv) == 3 else sys.stdout
+    receiver = Receiver(out, sys.stderr)
+    port = open_port(argv[1])
+
+    try:
+        while True:
+            data = read_chunk(port)
+            if not data:
+                break
+            receiver.feed(data)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        receiver.finish()
+        receiver.report()
+        if out is not sys.stdout:
+            out.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))